@@ -1,26 +1,57 @@
 #include "algorithms.h"
 
+#include <algorithm>
 #include <iostream>
-
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+#include "aosoa_thomas_solver.h"
+#include "brick_thomas_solver.h"
+#include "compressed_thomas_solver.h"
+#include "cyclic_reduction_solver.h"
 #include "full_lapack_solver.h"
 #include "general_lapack_thomas_solver.h"
+#include "hybrid_thomas_solver.h"
+#include "isa_dispatch.h"
 #include "lapack_thomas_solver.h"
 #include "least_compute_thomas_solver.h"
 #include "least_memory_thomas_solver.h"
+#include "mixed_precision_thomas_solver.h"
+#include "numa_utils.h"
 #include "reference_thomas_solver.h"
+#include "rotating_thomas_solver.h"
+#include "task_thomas_solver.h"
 #include "tridiagonal_solver.h"
 
-template <typename real_t>
+template <typename real_t, typename index_t>
 std::map<std::string, std::unique_ptr<tridiagonal_solver>> get_solvers_map()
 {
 	std::map<std::string, std::unique_ptr<tridiagonal_solver>> solvers;
 
-	solvers.emplace("ref", std::make_unique<reference_thomas_solver<real_t>>());
-	solvers.emplace("lstc", std::make_unique<least_compute_thomas_solver<real_t>>());
-	solvers.emplace("lstm", std::make_unique<least_memory_thomas_solver<real_t>>());
-	solvers.emplace("lapack", std::make_unique<lapack_thomas_solver<real_t>>());
-	solvers.emplace("lapack2", std::make_unique<general_lapack_thomas_solver<real_t>>());
-	solvers.emplace("full_lapack", std::make_unique<full_lapack_solver<real_t>>());
+	solvers.emplace("ref", std::make_unique<reference_thomas_solver<real_t, index_t>>());
+	solvers.emplace("lstc", std::make_unique<least_compute_thomas_solver<real_t, index_t>>());
+	solvers.emplace("lstm", std::make_unique<least_memory_thomas_solver<real_t, index_t>>());
+	solvers.emplace("pcr", std::make_unique<cyclic_reduction_solver<real_t, index_t>>());
+	solvers.emplace("lstc_tasks", std::make_unique<task_thomas_solver<real_t, index_t>>());
+	solvers.emplace("lstc_compressed", std::make_unique<compressed_thomas_solver<real_t, index_t>>());
+	solvers.emplace("lstc_aosoa", std::make_unique<aosoa_thomas_solver<real_t, index_t>>());
+	solvers.emplace("lstc_bricks", std::make_unique<brick_thomas_solver<real_t, index_t>>());
+	solvers.emplace("lstc_rotating", std::make_unique<rotating_thomas_solver<real_t, index_t>>());
+	solvers.emplace("hybrid", std::make_unique<hybrid_thomas_solver<real_t, index_t>>());
+
+	// the storage and compute precisions of these are fixed regardless of the selected precision
+	solvers.emplace("lstc_mixed", std::make_unique<mixed_precision_thomas_solver<double, float, index_t>>());
+	solvers.emplace("lstc_bf16", std::make_unique<mixed_precision_thomas_solver<float, bf16_t, index_t>>());
+	solvers.emplace("lstc_fp16", std::make_unique<mixed_precision_thomas_solver<float, fp16_t, index_t>>());
+
+	// LAPACK interface takes 32-bit integers
+	if constexpr (std::is_same_v<index_t, std::int32_t>)
+	{
+		solvers.emplace("lapack", std::make_unique<lapack_thomas_solver<real_t>>());
+		solvers.emplace("lapack2", std::make_unique<general_lapack_thomas_solver<real_t>>());
+		solvers.emplace("full_lapack", std::make_unique<full_lapack_solver<real_t>>());
+	}
 
 	return solvers;
 }
@@ -28,43 +59,82 @@ std::map<std::string, std::unique_ptr<tridiagonal_solver>> get_solvers_map()
 algorithms::algorithms(bool double_precision, bool verbose) : verbose_(verbose)
 {
 	if (double_precision)
-		solvers_ = get_solvers_map<double>();
+	{
+		solvers_ = get_solvers_map<double, std::int32_t>();
+		large_solvers_ = get_solvers_map<double, std::int64_t>();
+	}
 	else
-		solvers_ = get_solvers_map<float>();
+	{
+		solvers_ = get_solvers_map<float, std::int32_t>();
+		large_solvers_ = get_solvers_map<float, std::int64_t>();
+	}
+}
+
+std::size_t algorithms::get_index_bits(const std::string& alg, const max_problem_t& problem,
+									   const nlohmann::json& params)
+{
+	// the padded and bricked layouts allocate more than the grid, so the solver is tuned to get its allocation
+	auto& solver = *solvers_.at(alg);
+	solver.tune(params);
+
+	const bool fits_32_bits =
+		solver.allocated_elements(problem) <= (std::size_t)std::numeric_limits<std::int32_t>::max();
+
+	// 64-bit indices only when the problem does not fit, unless requested explicitly
+	std::size_t index_bits = params.contains("index_bits") ? (std::size_t)params["index_bits"] : 0;
+
+	if (index_bits == 0)
+		return fits_32_bits ? 32 : 64;
+
+	if (index_bits != 32 && index_bits != 64)
+		throw std::runtime_error("index_bits must be 32 or 64");
+
+	if (index_bits == 32 && !fits_32_bits)
+		throw std::runtime_error("The problem has too many elements for 32-bit indices");
+
+	return index_bits;
+}
+
+tridiagonal_solver& algorithms::get_solver(const std::string& alg, std::size_t index_bits)
+{
+	if (index_bits == 32)
+		return *solvers_.at(alg);
+
+	if (!large_solvers_.contains(alg))
+		throw std::runtime_error("Algorithm " + alg + " does not support 64-bit indices");
+
+	return *large_solvers_.at(alg);
 }
 
 void algorithms::run(const std::string& alg, const max_problem_t& problem, const nlohmann::json& params,
 					 const std::string& output_file)
 {
-	auto& solver = solvers_.at(alg);
+	auto& solver = get_solver(alg, get_index_bits(alg, problem, params));
 
-	solver->prepare(problem);
-	solver->tune(params);
-	solver->initialize();
+	numa_utils::pin_threads(params);
+	isa_dispatch::select(params);
 
-	for (std::size_t i = 0; i < problem.iterations; i++)
-	{
-		solver->solve_x();
+	solver.tune(params);
+	solver.prepare(problem);
+	solver.initialize();
 
-		if (problem.dims > 1)
-			solver->solve_y();
+	if (verbose_)
+		numa_utils::print_page_distribution(solver.substrates_memory(), std::cerr);
 
-		if (problem.dims > 2)
-			solver->solve_z();
-	}
+	solver.solve_iterations(problem.iterations);
 
-	solver->save(output_file);
+	solver.save(output_file);
 }
 
 void common_prepare(tridiagonal_solver& alg, tridiagonal_solver& ref, const max_problem_t& problem,
 					const nlohmann::json& params)
 {
-	alg.prepare(problem);
 	alg.tune(params);
+	alg.prepare(problem);
 	alg.initialize();
 
-	ref.prepare(problem);
 	ref.tune(params);
+	ref.prepare(problem);
 	ref.initialize();
 }
 
@@ -100,8 +170,17 @@ std::pair<double, double> algorithms::common_validate(tridiagonal_solver& alg, t
 
 void algorithms::validate(const std::string& alg, const max_problem_t& problem, const nlohmann::json& params)
 {
-	auto& solver = solvers_.at(alg);
-	auto& ref_solver = solvers_.at("ref");
+	std::size_t index_bits = get_index_bits(alg, problem, params);
+
+	// the base algorithm of the storage precision validation runs with the same width
+	if (storage_precision_bases_.contains(alg))
+		index_bits = std::max(index_bits, get_index_bits(storage_precision_bases_.at(alg), problem, params));
+
+	auto& solver = get_solver(alg, index_bits);
+	auto& ref_solver = get_solver("ref", index_bits);
+
+	numa_utils::pin_threads(params);
+	isa_dispatch::select(params);
 
 	double max_absolute_diff_x = 0.;
 	double max_absolute_diff_y = 0.;
@@ -113,22 +192,22 @@ void algorithms::validate(const std::string& alg, const max_problem_t& problem,
 
 	// validate solve_x
 	{
-		common_prepare(*solver, *ref_solver, problem, params);
-		solver->solve_x();
-		ref_solver->solve_x();
+		common_prepare(solver, ref_solver, problem, params);
+		solver.solve_x();
+		ref_solver.solve_x();
 
-		std::tie(max_absolute_diff_x, rmse_x) = common_validate(*solver, *ref_solver, problem);
+		std::tie(max_absolute_diff_x, rmse_x) = common_validate(solver, ref_solver, problem);
 	}
 
 	if (problem.dims > 1)
 	{
 		// validate solve_y
 		{
-			common_prepare(*solver, *ref_solver, problem, params);
-			solver->solve_y();
-			ref_solver->solve_y();
+			common_prepare(solver, ref_solver, problem, params);
+			solver.solve_y();
+			ref_solver.solve_y();
 
-			std::tie(max_absolute_diff_y, rmse_y) = common_validate(*solver, *ref_solver, problem);
+			std::tie(max_absolute_diff_y, rmse_y) = common_validate(solver, ref_solver, problem);
 		}
 	}
 
@@ -136,17 +215,59 @@ void algorithms::validate(const std::string& alg, const max_problem_t& problem,
 	{
 		// validate solve_z
 		{
-			common_prepare(*solver, *ref_solver, problem, params);
-			solver->solve_z();
-			ref_solver->solve_z();
+			common_prepare(solver, ref_solver, problem, params);
+			solver.solve_z();
+			ref_solver.solve_z();
 
-			std::tie(max_absolute_diff_z, rmse_z) = common_validate(*solver, *ref_solver, problem);
+			std::tie(max_absolute_diff_z, rmse_z) = common_validate(solver, ref_solver, problem);
 		}
 	}
 
+	// validate the whole step
+	double max_absolute_diff_step, rmse_step;
+	{
+		common_prepare(solver, ref_solver, problem, params);
+		solver.solve();
+		ref_solver.solve();
+
+		std::tie(max_absolute_diff_step, rmse_step) = common_validate(solver, ref_solver, problem);
+	}
+
 	std::cout << "X - Maximal absolute difference: " << max_absolute_diff_x << ", RMSE:" << rmse_x << std::endl;
 	std::cout << "Y - Maximal absolute difference: " << max_absolute_diff_y << ", RMSE:" << rmse_y << std::endl;
 	std::cout << "Z - Maximal absolute difference: " << max_absolute_diff_z << ", RMSE:" << rmse_z << std::endl;
+	std::cout << "Step - Maximal absolute difference: " << max_absolute_diff_step << ", RMSE:" << rmse_step
+			  << std::endl;
+
+	if (storage_precision_bases_.contains(alg))
+		validate_storage_precision(alg, storage_precision_bases_.at(alg), problem, params, index_bits);
+}
+
+void algorithms::validate_storage_precision(const std::string& alg, const std::string& base_alg,
+											const max_problem_t& problem, const nlohmann::json& params,
+											std::size_t index_bits)
+{
+	auto float_solvers =
+		index_bits == 32 ? get_solvers_map<float, std::int32_t>() : get_solvers_map<float, std::int64_t>();
+	auto double_solvers =
+		index_bits == 32 ? get_solvers_map<double, std::int32_t>() : get_solvers_map<double, std::int64_t>();
+
+	auto& ref_solver = *double_solvers.at("ref");
+
+	auto step_rmse = [&](tridiagonal_solver& solver) {
+		common_prepare(solver, ref_solver, problem, params);
+		solver.solve();
+		ref_solver.solve();
+
+		return common_validate(solver, ref_solver, problem).second;
+	};
+
+	const double rmse_float = step_rmse(*float_solvers.at(base_alg));
+	const double rmse_double = step_rmse(*double_solvers.at(base_alg));
+	const double rmse_alg = step_rmse(get_solver(alg, index_bits));
+
+	std::cout << "Step RMSE against the double reference - float " << base_alg << ": " << rmse_float << ", double "
+			  << base_alg << ": " << rmse_double << ", " << alg << ": " << rmse_alg << std::endl;
 }
 
 template <typename func_t>
@@ -169,8 +290,8 @@ std::vector<std::size_t> warmup_and_measure(tridiagonal_solver& solver, const ma
 	{
 		for (std::size_t i = 0; i < 10; i++)
 		{
-			solver.prepare(problem);
 			solver.tune(params);
+			solver.prepare(problem);
 			solver.initialize();
 
 			auto start = std::chrono::high_resolution_clock::now();
@@ -188,13 +309,15 @@ void algorithms::benchmark_inner(const std::string& alg, const max_problem_t& pr
 {
 	auto inner_iterations = params.contains("inner_iterations") ? (std::size_t)params["inner_iterations"] : 10;
 
-	auto& solver = *solvers_.at(alg);
+	const std::size_t index_bits = get_index_bits(alg, problem, params);
+
+	auto& solver = get_solver(alg, index_bits);
 
-	solver.prepare(problem);
 	solver.tune(params);
+	solver.prepare(problem);
 
 	std::size_t init_time_us;
-	std::vector<std::size_t> times_x, times_y, times_z;
+	std::vector<std::size_t> times_x, times_y, times_z, times_step;
 
 	{
 		auto start = std::chrono::high_resolution_clock::now();
@@ -235,6 +358,26 @@ void algorithms::benchmark_inner(const std::string& alg, const max_problem_t& pr
 		}
 	}
 
+	for (std::size_t i = 0; i < inner_iterations; i++)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		solver.solve();
+		auto end = std::chrono::high_resolution_clock::now();
+
+		times_step.push_back(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+	}
+
+	// all steps solved at once, so the solver can avoid the per-step synchronization
+	double multistep_time;
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		solver.solve_iterations(inner_iterations);
+		auto end = std::chrono::high_resolution_clock::now();
+
+		multistep_time =
+			(double)std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / inner_iterations;
+	}
+
 	auto compute_mean_and_std = [](const std::vector<std::size_t>& times) {
 		double mean = std::accumulate(times.begin(), times.end(), 0.0) / times.size();
 		double sq_sum = std::inner_product(times.begin(), times.end(), times.begin(), 0.0);
@@ -245,21 +388,36 @@ void algorithms::benchmark_inner(const std::string& alg, const max_problem_t& pr
 	auto [x_mean, x_std] = compute_mean_and_std(times_x);
 	auto [y_mean, y_std] = compute_mean_and_std(times_y);
 	auto [z_mean, z_std] = compute_mean_and_std(times_z);
+	auto [step_mean, step_std] = compute_mean_and_std(times_step);
+
+	// each sweep reads and writes all densities once
+	const double step_bandwidth = 2. * problem.dims * solver.substrates_memory().size() / (step_mean * 1e3);
 
 	std::cout << alg << "," << problem.dims << "," << problem.substrates_count << "," << problem.nx << "," << problem.ny
 			  << "," << problem.nz << "," << init_time_us << "," << 10 << "," << x_mean << "," << y_mean << ","
-			  << z_mean << "," << x_std << "," << y_std << "," << z_std << std::endl;
+			  << z_mean << "," << x_std << "," << y_std << "," << z_std << "," << step_mean << "," << step_std
+			  << "," << multistep_time << "," << index_bits << "," << step_bandwidth << ","
+			  << isa_dispatch::name(isa_dispatch::selected()) << std::endl;
 }
 
 void algorithms::benchmark(const std::string& alg, const max_problem_t& problem, const nlohmann::json& params)
 {
-	auto& solver = solvers_.at(alg);
+	auto& solver = get_solver(alg, get_index_bits(alg, problem, params));
 
-	std::cout << "algorithm,dims,s,nx,ny,nz,init_time,repetitions,x_time,y_time,z_time,x_std,y_std,z_std" << std::endl;
+	std::cout << "algorithm,dims,s,nx,ny,nz,init_time,repetitions,x_time,y_time,z_time,x_std,y_std,z_std,step_time,"
+				 "step_std,multistep_time,index_bits,step_bandwidth,isa"
+			  << std::endl;
 
-	solver->prepare(problem);
-	solver->tune(params);
-	solver->initialize();
+	numa_utils::pin_threads(params);
+	isa_dispatch::select(params);
+
+	solver.tune(params);
+	solver.prepare(problem);
+	solver.initialize();
+
+	// to stderr, so the csv output stays intact
+	if (verbose_)
+		numa_utils::print_page_distribution(solver.substrates_memory(), std::cerr);
 
 	// warmup
 	{
@@ -268,10 +426,8 @@ void algorithms::benchmark(const std::string& alg, const max_problem_t& problem,
 		auto end = start;
 		do
 		{
-			solver->initialize();
-			solver->solve_x();
-			solver->solve_y();
-			solver->solve_z();
+			solver.initialize();
+			solver.solve();
 			end = std::chrono::high_resolution_clock::now();
 		} while ((double)std::chrono::duration_cast<std::chrono::seconds>(end - start).count() < warmup_time_s);
 	}
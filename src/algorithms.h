@@ -10,14 +10,34 @@ class algorithms
 {
 	std::map<std::string, std::unique_ptr<tridiagonal_solver>> solvers_;
 
+	// the same solvers with 64-bit indices, for problems that overflow 32-bit indices
+	std::map<std::string, std::unique_ptr<tridiagonal_solver>> large_solvers_;
+
 	bool verbose_;
 
 	static constexpr double relative_difference_print_threshold_ = 0.01;
 	static constexpr double absolute_difference_print_threshold_ = 1e-6;
 
+	// the algorithms storing the densities in a different precision than they compute in, mapped to the algorithm
+	// they are derived from
+	inline static const std::map<std::string, std::string> storage_precision_bases_ = {
+		{ "lstc_mixed", "lstc" }, { "lstc_bf16", "lstc" }, { "lstc_fp16", "lstc" }
+	};
+
 	std::pair<double, double> common_validate(tridiagonal_solver& alg, tridiagonal_solver& ref,
 											  const max_problem_t& problem);
 
+	// Returns 32 or 64 - the "index_bits" param if set, otherwise the narrowest width fitting the densities the
+	// algorithm allocates for the problem
+	std::size_t get_index_bits(const std::string& alg, const max_problem_t& problem, const nlohmann::json& params);
+
+	tridiagonal_solver& get_solver(const std::string& alg, std::size_t index_bits);
+
+	// Prints the step RMSE of the algorithm and of the float and double versions of its base algorithm, all against the
+	// double reference
+	void validate_storage_precision(const std::string& alg, const std::string& base_alg, const max_problem_t& problem,
+									const nlohmann::json& params, std::size_t index_bits);
+
 	void benchmark_inner(const std::string& alg, const max_problem_t& problem, const nlohmann::json& params);
 
 public:
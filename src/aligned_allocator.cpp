@@ -0,0 +1,87 @@
+#include "aligned_allocator.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#ifdef __linux__
+	#include <sys/mman.h>
+#endif
+
+static constexpr std::size_t huge_page_size = 2 << 20;
+
+static std::size_t round_up(std::size_t bytes, std::size_t alignment)
+{
+	return (bytes + alignment - 1) / alignment * alignment;
+}
+
+void aligned_deleter::operator()(void* ptr) const
+{
+#ifdef __linux__
+	if (mapped_bytes != 0)
+	{
+		munmap(ptr, mapped_bytes);
+		return;
+	}
+#endif
+
+	std::free(ptr);
+}
+
+void aligned_allocator::tune(const nlohmann::json& params)
+{
+	alignment_ = params.contains("alignment") ? (std::size_t)params["alignment"] : 64;
+
+	if (alignment_ < alignof(std::max_align_t) || (alignment_ & (alignment_ - 1)) != 0)
+		throw std::runtime_error("The alignment must be a power of two of at least "
+								 + std::to_string(alignof(std::max_align_t)) + " bytes");
+
+	std::string huge_pages = params.contains("huge_pages") ? (std::string)params["huge_pages"] : "none";
+
+	if (huge_pages == "none")
+		huge_pages_ = huge_pages_mode::none;
+	else if (huge_pages == "transparent")
+		huge_pages_ = huge_pages_mode::transparent;
+	else if (huge_pages == "explicit")
+		huge_pages_ = huge_pages_mode::explicit_pages;
+	else
+		throw std::runtime_error("Unknown huge_pages mode: " + huge_pages);
+}
+
+std::pair<void*, aligned_deleter> aligned_allocator::allocate_bytes(std::size_t bytes) const
+{
+	std::size_t alignment = alignment_;
+
+#ifdef __linux__
+	if (huge_pages_ != huge_pages_mode::none && bytes >= huge_page_size)
+	{
+		const std::size_t mapped_bytes = round_up(bytes, huge_page_size);
+
+		if (huge_pages_ == huge_pages_mode::explicit_pages)
+		{
+			void* ptr = mmap(nullptr, mapped_bytes, PROT_READ | PROT_WRITE,
+							 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+			if (ptr != MAP_FAILED)
+				return { ptr, aligned_deleter { mapped_bytes } };
+		}
+
+		alignment = std::max(alignment, huge_page_size);
+	}
+#endif
+
+	void* ptr = std::aligned_alloc(alignment, round_up(bytes, alignment));
+
+	if (ptr == nullptr && bytes != 0)
+		throw std::bad_alloc();
+
+#ifdef __linux__
+	// only a hint, the memory is usable without huge pages as well
+	if (alignment >= huge_page_size)
+		madvise(ptr, round_up(bytes, huge_page_size), MADV_HUGEPAGE);
+#endif
+
+	return { ptr, aligned_deleter {} };
+}
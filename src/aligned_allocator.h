@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+#include <nlohmann/json.hpp>
+
+// Frees the memory of aligned_allocator, mapped_bytes is non-zero for the memory mapped by mmap
+struct aligned_deleter
+{
+	std::size_t mapped_bytes = 0;
+
+	void operator()(void* ptr) const;
+};
+
+template <typename T>
+using aligned_buffer = std::unique_ptr<T[], aligned_deleter>;
+
+/*
+Allocator of the solver buffers. The buffers are left uninitialized (the solvers overwrite them anyway) and aligned to
+the "alignment" param (64 bytes by default). The "huge_pages" param selects how buffers spanning at least one 2 MiB
+page are backed:
+- "none" (default) - regular pages,
+- "transparent" - 2 MiB aligned memory advised to the kernel as a transparent huge page candidate (madvise),
+- "explicit" - memory mapped from the reserved huge page pool (mmap with MAP_HUGETLB), which falls back to
+  "transparent" when the pool is exhausted.
+*/
+class aligned_allocator
+{
+public:
+	enum class huge_pages_mode
+	{
+		none,
+		transparent,
+		explicit_pages
+	};
+
+private:
+	std::size_t alignment_ = 64;
+	huge_pages_mode huge_pages_ = huge_pages_mode::none;
+
+	std::pair<void*, aligned_deleter> allocate_bytes(std::size_t bytes) const;
+
+public:
+	void tune(const nlohmann::json& params);
+
+	template <typename T>
+	aligned_buffer<T> allocate(std::size_t count) const
+	{
+		static_assert(std::is_trivially_default_constructible_v<T> && std::is_trivially_destructible_v<T>);
+
+		auto [ptr, deleter] = allocate_bytes(count * sizeof(T));
+
+		return aligned_buffer<T>(static_cast<T*>(ptr), deleter);
+	}
+};
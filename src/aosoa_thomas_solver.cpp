@@ -0,0 +1,409 @@
+#include "aosoa_thomas_solver.h"
+
+#include <algorithm>
+#include <omp.h>
+
+#include "solver_utils.h"
+
+template <typename real_t, typename index_t>
+void aosoa_thomas_solver<real_t, index_t>::precompute_lane_values(lane_values_t& values, index_t shape, index_t dims,
+																  index_t n)
+{
+	const index_t substrates_count = this->problem_.substrates_count;
+	const index_t chunk_len = get_chunk_len(n);
+	const index_t lanes = lanes_;
+
+	values.r = this->allocator_.template allocate<real_t>(lanes * chunk_len * substrates_count);
+	values.a_r = this->allocator_.template allocate<real_t>(lanes * chunk_len * substrates_count);
+	values.c_forward = this->allocator_.template allocate<real_t>(lanes * chunk_len * substrates_count);
+	values.a_final = this->allocator_.template allocate<real_t>(lanes * chunk_len * substrates_count);
+	values.c_final = this->allocator_.template allocate<real_t>(lanes * chunk_len * substrates_count);
+	values.r_first = this->allocator_.template allocate<real_t>(lanes * substrates_count);
+	values.reduced_b = this->allocator_.template allocate<real_t>(2 * lanes * substrates_count);
+	values.reduced_c = this->allocator_.template allocate<real_t>(2 * lanes * substrates_count);
+	values.reduced_e = this->allocator_.template allocate<real_t>(2 * lanes * substrates_count);
+
+	auto diag_l = noarr::scalar<real_t>() ^ noarr::vectors<'v', 'i', 's'>(lanes, chunk_len, substrates_count);
+	auto first_l = noarr::scalar<real_t>() ^ noarr::vectors<'v', 's'>(lanes, substrates_count);
+	auto reduced_l = noarr::scalar<real_t>() ^ noarr::vectors<'r', 's'>(2 * lanes, substrates_count);
+
+	auto r = noarr::make_bag(diag_l, values.r.get());
+	auto a_r = noarr::make_bag(diag_l, values.a_r.get());
+	auto c_forward = noarr::make_bag(diag_l, values.c_forward.get());
+	auto a_final = noarr::make_bag(diag_l, values.a_final.get());
+	auto c_final = noarr::make_bag(diag_l, values.c_final.get());
+
+	for (index_t s = 0; s < substrates_count; s++)
+	{
+		const real_t coef = -this->problem_.dt * this->problem_.diffusion_coefficients[s] / (shape * shape);
+
+		// the padding rows past n are decoupled identity rows
+		auto a = [&](index_t i) { return (i == 0 || i >= n) ? 0 : coef; };
+		auto c = [&](index_t i) { return i >= n - 1 ? 0 : coef; };
+		auto b = [&](index_t i) -> real_t {
+			if (i >= n)
+				return 1;
+
+			return 1 + this->problem_.decay_rates[s] * this->problem_.dt / dims
+				   - ((i == 0 || i == n - 1) ? 1 : 2) * coef;
+		};
+
+		for (index_t v = 0; v < lanes; v++)
+		{
+			const index_t begin = v * chunk_len;
+
+			// modified forward substitution
+			for (index_t i = 0; i < 2; i++)
+			{
+				r.template at<'v', 'i', 's'>(v, i, s) = 1 / b(begin + i);
+				a_r.template at<'v', 'i', 's'>(v, i, s) = 0;
+				a_final.template at<'v', 'i', 's'>(v, i, s) = a(begin + i) * r.template at<'v', 'i', 's'>(v, i, s);
+				c_forward.template at<'v', 'i', 's'>(v, i, s) = c(begin + i) * r.template at<'v', 'i', 's'>(v, i, s);
+			}
+
+			for (index_t i = 2; i < chunk_len; i++)
+			{
+				r.template at<'v', 'i', 's'>(v, i, s) =
+					1 / (b(begin + i) - a(begin + i) * c_forward.template at<'v', 'i', 's'>(v, i - 1, s));
+				a_r.template at<'v', 'i', 's'>(v, i, s) = a(begin + i) * r.template at<'v', 'i', 's'>(v, i, s);
+				a_final.template at<'v', 'i', 's'>(v, i, s) = -a(begin + i)
+															  * a_final.template at<'v', 'i', 's'>(v, i - 1, s)
+															  * r.template at<'v', 'i', 's'>(v, i, s);
+				c_forward.template at<'v', 'i', 's'>(v, i, s) = c(begin + i) * r.template at<'v', 'i', 's'>(v, i, s);
+			}
+
+			// modified backward substitution
+			for (index_t i = chunk_len - 2; i < chunk_len; i++)
+				c_final.template at<'v', 'i', 's'>(v, i, s) = c_forward.template at<'v', 'i', 's'>(v, i, s);
+
+			for (index_t i = chunk_len - 3; i > 0; i--)
+			{
+				a_final.template at<'v', 'i', 's'>(v, i, s) -=
+					c_forward.template at<'v', 'i', 's'>(v, i, s) * a_final.template at<'v', 'i', 's'>(v, i + 1, s);
+				c_final.template at<'v', 'i', 's'>(v, i, s) =
+					-c_forward.template at<'v', 'i', 's'>(v, i, s) * c_final.template at<'v', 'i', 's'>(v, i + 1, s);
+			}
+
+			{
+				real_t r_first = 1 / (1 - c_forward.template at<'v', 'i', 's'>(v, 0, s)
+											  * a_final.template at<'v', 'i', 's'>(v, 1, s));
+
+				(first_l | noarr::get_at<'v', 's'>(values.r_first.get(), v, s)) = r_first;
+				a_final.template at<'v', 'i', 's'>(v, 0, s) *= r_first;
+				c_final.template at<'v', 'i', 's'>(v, 0, s) = -r_first * c_forward.template at<'v', 'i', 's'>(v, 0, s)
+															  * c_final.template at<'v', 'i', 's'>(v, 1, s);
+			}
+		}
+
+		// Thomas values of the reduced system, where the row 2v is the first and the row 2v+1 is the last row of the
+		// chunk of lane v; the reduced diagonal is 1
+		real_t prev_b = 0, prev_c = 0;
+		for (index_t row = 0; row < 2 * lanes; row++)
+		{
+			const index_t i = row % 2 == 0 ? 0 : chunk_len - 1;
+
+			const real_t reduced_a = a_final.template at<'v', 'i', 's'>(row / 2, i, s);
+			const real_t reduced_c = c_final.template at<'v', 'i', 's'>(row / 2, i, s);
+
+			const real_t reduced_e = row == 0 ? 0 : reduced_a * prev_b;
+			const real_t reduced_b = 1 / (1 - reduced_e * prev_c);
+
+			(reduced_l | noarr::get_at<'r', 's'>(values.reduced_b.get(), row, s)) = reduced_b;
+			(reduced_l | noarr::get_at<'r', 's'>(values.reduced_c.get(), row, s)) = reduced_c;
+			(reduced_l | noarr::get_at<'r', 's'>(values.reduced_e.get(), row, s)) = reduced_e;
+
+			prev_b = reduced_b;
+			prev_c = reduced_c;
+		}
+	}
+}
+
+template <typename real_t, typename index_t>
+void aosoa_thomas_solver<real_t, index_t>::prepare(const max_problem_t& problem)
+{
+	this->problem_ = problems::cast<index_t, real_t>(problem);
+	this->substrates_ = this->allocator_.template allocate<real_t>(get_padded_size(this->problem_));
+
+	// Initialize substrates
+
+	auto aosoa_layout = get_aosoa_layout(this->problem_, this->problem_.substrates_count);
+
+	// zeroes also the padding rows
+	if (this->problem_.dims == 3)
+		solver_utils::first_touch<'z'>(aosoa_layout, this->substrates_.get(), this->work_items_);
+	else
+		solver_utils::first_touch<'y'>(aosoa_layout, this->substrates_.get(), this->work_items_);
+
+	solver_utils::initialize_substrate(get_grid_layout(this->problem_), this->substrates_.get(), this->problem_);
+}
+
+template <typename real_t, typename index_t>
+void aosoa_thomas_solver<real_t, index_t>::initialize()
+{
+	if (this->problem_.dims >= 1)
+		precompute_lane_values(valuesx_, this->problem_.dx, this->problem_.dims, this->problem_.nx);
+	if (this->problem_.dims >= 2)
+		this->precompute_values(this->by_, this->cy_, this->ey_, this->problem_.dy, this->problem_.dims,
+								this->problem_.ny, 1);
+	if (this->problem_.dims >= 3)
+		this->precompute_values(this->bz_, this->cz_, this->ez_, this->problem_.dz, this->problem_.dims,
+								this->problem_.nz, 1);
+}
+
+// Solves the x line m of the substrate s; every vector loop runs the same row of the chunks of all lanes, only the
+// reduced system is solved lane by lane
+template <typename index_t, typename real_t, typename values_t, typename density_layout_t>
+inline void solve_line_x_lanes(real_t* __restrict__ densities, const values_t& values, const density_layout_t dens_l,
+							   index_t s, index_t m)
+{
+	const real_t* __restrict__ r = values.r.get();
+	const real_t* __restrict__ a_r = values.a_r.get();
+	const real_t* __restrict__ c_forward = values.c_forward.get();
+	const real_t* __restrict__ a_final = values.a_final.get();
+	const real_t* __restrict__ c_final = values.c_final.get();
+	const real_t* __restrict__ r_first = values.r_first.get();
+	const real_t* __restrict__ reduced_b = values.reduced_b.get();
+	const real_t* __restrict__ reduced_c = values.reduced_c.get();
+	const real_t* __restrict__ reduced_e = values.reduced_e.get();
+
+	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+	const index_t n = dens_l | noarr::get_length<'c'>();
+	const index_t lanes = dens_l | noarr::get_length<'v'>();
+
+	auto diag_l = noarr::scalar<real_t>() ^ noarr::vectors<'v', 'i', 's'>(lanes, n, substrates_count);
+	auto first_l = noarr::scalar<real_t>() ^ noarr::vectors<'v', 's'>(lanes, substrates_count);
+	auto reduced_l = noarr::scalar<real_t>() ^ noarr::vectors<'r', 's'>(2 * lanes, substrates_count);
+
+	// modified forward and backward substitution of the chunks
+#pragma omp simd
+	for (index_t v = 0; v < lanes; v++)
+	{
+		(dens_l | noarr::get_at<'m', 's', 'c', 'v'>(densities, m, s, 0, v)) *=
+			(diag_l | noarr::get_at<'v', 'i', 's'>(r, v, 0, s));
+	}
+
+	for (index_t i = 1; i < n; i++)
+	{
+#pragma omp simd
+		for (index_t v = 0; v < lanes; v++)
+		{
+			(dens_l | noarr::get_at<'m', 's', 'c', 'v'>(densities, m, s, i, v)) =
+				(dens_l | noarr::get_at<'m', 's', 'c', 'v'>(densities, m, s, i, v))
+					* (diag_l | noarr::get_at<'v', 'i', 's'>(r, v, i, s))
+				- (diag_l | noarr::get_at<'v', 'i', 's'>(a_r, v, i, s))
+					  * (dens_l | noarr::get_at<'m', 's', 'c', 'v'>(densities, m, s, i - 1, v));
+		}
+	}
+
+	for (index_t i = n - 3; i > 0; i--)
+	{
+#pragma omp simd
+		for (index_t v = 0; v < lanes; v++)
+		{
+			(dens_l | noarr::get_at<'m', 's', 'c', 'v'>(densities, m, s, i, v)) -=
+				(diag_l | noarr::get_at<'v', 'i', 's'>(c_forward, v, i, s))
+				* (dens_l | noarr::get_at<'m', 's', 'c', 'v'>(densities, m, s, i + 1, v));
+		}
+	}
+
+#pragma omp simd
+	for (index_t v = 0; v < lanes; v++)
+	{
+		(dens_l | noarr::get_at<'m', 's', 'c', 'v'>(densities, m, s, 0, v)) =
+			((dens_l | noarr::get_at<'m', 's', 'c', 'v'>(densities, m, s, 0, v))
+			 - (diag_l | noarr::get_at<'v', 'i', 's'>(c_forward, v, 0, s))
+				   * (dens_l | noarr::get_at<'m', 's', 'c', 'v'>(densities, m, s, 1, v)))
+			* (first_l | noarr::get_at<'v', 's'>(r_first, v, s));
+	}
+
+	// Thomas solve of the reduced system made of the first and the last rows of the chunks
+	auto reduced_density = [=](index_t row) -> real_t& {
+		return dens_l | noarr::get_at<'m', 's', 'c', 'v'>(densities, m, s, row % 2 == 0 ? 0 : n - 1, row / 2);
+	};
+
+	for (index_t row = 1; row < 2 * lanes; row++)
+	{
+		reduced_density(row) -= (reduced_l | noarr::get_at<'r', 's'>(reduced_e, row, s)) * reduced_density(row - 1);
+	}
+
+	reduced_density(2 * lanes - 1) *= (reduced_l | noarr::get_at<'r', 's'>(reduced_b, 2 * lanes - 1, s));
+
+	for (index_t row = 2 * lanes - 2; row >= 0; row--)
+	{
+		reduced_density(row) =
+			(reduced_density(row) - (reduced_l | noarr::get_at<'r', 's'>(reduced_c, row, s)) * reduced_density(row + 1))
+			* (reduced_l | noarr::get_at<'r', 's'>(reduced_b, row, s));
+	}
+
+	// back-fill of the inner rows of the chunks
+	for (index_t i = 1; i < n - 1; i++)
+	{
+#pragma omp simd
+		for (index_t v = 0; v < lanes; v++)
+		{
+			(dens_l | noarr::get_at<'m', 's', 'c', 'v'>(densities, m, s, i, v)) -=
+				(diag_l | noarr::get_at<'v', 'i', 's'>(a_final, v, i, s))
+					* (dens_l | noarr::get_at<'m', 's', 'c', 'v'>(densities, m, s, 0, v))
+				+ (diag_l | noarr::get_at<'v', 'i', 's'>(c_final, v, i, s))
+					  * (dens_l | noarr::get_at<'m', 's', 'c', 'v'>(densities, m, s, n - 1, v));
+		}
+	}
+}
+
+// The lines of the substrates are independent, so they are distributed together with m; a 1D problem has a single m
+template <typename index_t, typename real_t, typename values_t, typename density_layout_t>
+void solve_slice_x_lanes(real_t* __restrict__ densities, const values_t& values, const density_layout_t dens_l,
+						 std::size_t work_items)
+{
+	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+	const index_t m_len = dens_l | noarr::get_length<'m'>();
+
+#pragma omp for collapse(2) schedule(static, work_items)
+	for (index_t m = 0; m < m_len; m++)
+	{
+		for (index_t s = 0; s < substrates_count; s++)
+		{
+			solve_line_x_lanes<index_t>(densities, values, dens_l, s, m);
+		}
+	}
+}
+
+// Solves the y lines of the z slab; the row of a substrate is contiguous across the chunk rows and lanes (merged to
+// 'q'), so each row is a single vector loop
+template <typename index_t, typename real_t, typename density_layout_t>
+inline void solve_slab_y_lanes(real_t* __restrict__ densities, const real_t* __restrict__ b,
+							   const real_t* __restrict__ c, const real_t* __restrict__ e,
+							   const density_layout_t dens_l, index_t z)
+{
+	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+	const index_t n = dens_l | noarr::get_length<'y'>();
+	const index_t q_len = dens_l | noarr::get_length<'q'>();
+
+	auto diag_l = noarr::scalar<real_t>() ^ noarr::vector<'s'>(substrates_count) ^ noarr::vector<'i'>(n);
+
+	for (index_t i = 1; i < n; i++)
+	{
+		for (index_t s = 0; s < substrates_count; s++)
+		{
+#pragma omp simd
+			for (index_t q = 0; q < q_len; q++)
+			{
+				(dens_l | noarr::get_at<'z', 'y', 's', 'q'>(densities, z, i, s, q)) =
+					(dens_l | noarr::get_at<'z', 'y', 's', 'q'>(densities, z, i, s, q))
+					- (diag_l | noarr::get_at<'i', 's'>(e, i - 1, s))
+						  * (dens_l | noarr::get_at<'z', 'y', 's', 'q'>(densities, z, i - 1, s, q));
+			}
+		}
+	}
+
+	for (index_t s = 0; s < substrates_count; s++)
+	{
+#pragma omp simd
+		for (index_t q = 0; q < q_len; q++)
+		{
+			(dens_l | noarr::get_at<'z', 'y', 's', 'q'>(densities, z, n - 1, s, q)) =
+				(dens_l | noarr::get_at<'z', 'y', 's', 'q'>(densities, z, n - 1, s, q))
+				* (diag_l | noarr::get_at<'i', 's'>(b, n - 1, s));
+		}
+	}
+
+	for (index_t i = n - 2; i >= 0; i--)
+	{
+		for (index_t s = 0; s < substrates_count; s++)
+		{
+#pragma omp simd
+			for (index_t q = 0; q < q_len; q++)
+			{
+				(dens_l | noarr::get_at<'z', 'y', 's', 'q'>(densities, z, i, s, q)) =
+					((dens_l | noarr::get_at<'z', 'y', 's', 'q'>(densities, z, i, s, q))
+					 - c[s] * (dens_l | noarr::get_at<'z', 'y', 's', 'q'>(densities, z, i + 1, s, q)))
+					* (diag_l | noarr::get_at<'i', 's'>(b, i, s));
+			}
+		}
+	}
+}
+
+template <typename real_t, typename index_t>
+void aosoa_thomas_solver<real_t, index_t>::solve_x_omp()
+{
+	solver_utils::dispatch_substrates_count(
+		this->problem_.substrates_count, this->specialized_, [&](auto substrates_count) {
+			solve_slice_x_lanes<index_t>(this->substrates_.get(), valuesx_,
+										 get_aosoa_layout(this->problem_, substrates_count)
+											 ^ noarr::merge_blocks<'z', 'y', 'm'>(),
+										 this->work_items_);
+		});
+}
+
+template <typename real_t, typename index_t>
+void aosoa_thomas_solver<real_t, index_t>::solve_y_omp()
+{
+	if (this->problem_.dims < 2)
+		return;
+
+	solver_utils::dispatch_substrates_count(
+		this->problem_.substrates_count, this->specialized_, [&](auto substrates_count) {
+			auto dens_l = get_aosoa_layout(this->problem_, substrates_count) ^ noarr::merge_blocks<'c', 'v', 'q'>();
+
+			const index_t z_len = this->problem_.nz;
+			const index_t q_len = dens_l | noarr::get_length<'q'>();
+
+			const index_t q_blocks = this->get_slab_blocks(q_len);
+
+#pragma omp for collapse(2) schedule(static, this->work_items_)
+			for (index_t z = 0; z < z_len; z++)
+			{
+				for (index_t block = 0; block < q_blocks; block++)
+				{
+					const index_t q_begin = block * q_len / q_blocks;
+					const index_t q_end = (block + 1) * q_len / q_blocks;
+
+					solve_slab_y_lanes<index_t>(this->substrates_.get(), this->by_.get(), this->cy_.get(),
+												this->ey_.get(), dens_l ^ noarr::slice<'q'>(q_begin, q_end - q_begin),
+												z);
+				}
+			}
+		});
+}
+
+template <typename real_t, typename index_t>
+void aosoa_thomas_solver<real_t, index_t>::solve_z_omp()
+{
+	if (this->problem_.dims < 3)
+		return;
+
+	solver_utils::dispatch_substrates_count(
+		this->problem_.substrates_count, this->specialized_, [&](auto substrates_count) {
+			// a y row of the z lines is solved as a y slab with swapped y and z
+			auto dens_l = get_aosoa_layout(this->problem_, substrates_count) ^ noarr::merge_blocks<'c', 'v', 'q'>()
+						  ^ noarr::rename<'z', 'y', 'y', 'z'>();
+
+			const index_t y_len = this->problem_.ny;
+
+#pragma omp for schedule(static, this->work_items_)
+			for (index_t y = 0; y < y_len; y++)
+			{
+				solve_slab_y_lanes<index_t>(this->substrates_.get(), this->bz_.get(), this->cz_.get(),
+											this->ez_.get(), dens_l, y);
+			}
+		});
+}
+
+template <typename real_t, typename index_t>
+std::span<const std::byte> aosoa_thomas_solver<real_t, index_t>::substrates_memory() const
+{
+	return std::as_bytes(std::span(this->substrates_.get(), get_padded_size(this->problem_)));
+}
+
+template <typename real_t, typename index_t>
+double aosoa_thomas_solver<real_t, index_t>::access(std::size_t s, std::size_t x, std::size_t y, std::size_t z) const
+{
+	auto dens_l = get_grid_layout(this->problem_);
+
+	return (dens_l | noarr::get_at<'s', 'x', 'y', 'z'>(this->substrates_.get(), s, x, y, z));
+}
+
+template class aosoa_thomas_solver<float, std::int32_t>;
+template class aosoa_thomas_solver<float, std::int64_t>;
+template class aosoa_thomas_solver<double, std::int32_t>;
+template class aosoa_thomas_solver<double, std::int64_t>;
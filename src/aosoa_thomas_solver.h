@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+
+#include "least_compute_thomas_solver.h"
+
+/*
+The same systems as least_compute_thomas_solver, but the densities are stored in a substrate-blocked
+array-of-structures-of-arrays layout, which keeps the SIMD lanes full even for 1-3 substrates.
+
+Each x line is split into 'lanes' chunks (a cache line worth of reals) of chunk_len rows, where the lane v holds the
+rows v*chunk_len ... (v+1)*chunk_len - 1. The lanes of the same chunk row are stored next to each other, so the layout
+is (from the innermost) lane, chunk row, substrate, y, z. The line is padded to lanes*chunk_len rows with decoupled
+identity rows, which stay zero.
+
+The y and z sweeps run the least_compute recurrence over whole rows of a substrate, which are contiguous across the
+chunk rows and lanes. The x sweep runs the partitioned (SPIKE-like) variant of least_memory_thomas_solver with one
+chunk per lane: all lanes run the modified forward and backward substitutions of their chunks at once, the reduced
+system of the first and the last rows of the chunks (2*lanes rows) is solved by a single Thomas pass and finally all
+lanes back-fill the inner rows of their chunks.
+*/
+
+template <typename real_t, typename index_t>
+class aosoa_thomas_solver : public least_compute_variant<real_t, index_t>
+{
+	using base_t = least_compute_variant<real_t, index_t>;
+
+	static constexpr std::size_t lanes_ = 64 / sizeof(real_t);
+
+	struct lane_values_t
+	{
+		// chunk_len x substrates_count x lanes: the modified forward substitution factors and the couplings of the
+		// inner rows to the first and the last row of their chunk
+		aligned_buffer<real_t> r, a_r, c_forward, a_final, c_final;
+
+		// substrates_count x lanes: the first row factors of the modified backward substitution
+		aligned_buffer<real_t> r_first;
+
+		// 2*lanes x substrates_count: precomputed Thomas values of the reduced system
+		aligned_buffer<real_t> reduced_b, reduced_c, reduced_e;
+	};
+
+	lane_values_t valuesx_;
+
+	// each chunk needs at least 3 rows for the modified substitutions
+	static index_t get_chunk_len(index_t n)
+	{
+		return std::max<index_t>(3, (n + (index_t)lanes_ - 1) / (index_t)lanes_);
+	}
+
+	// The substrates count is either index_t or noarr::lit for the specialized kernels
+	template <typename substrates_count_t>
+	static auto get_aosoa_layout(const problem_t<index_t, real_t>& problem, substrates_count_t substrates_count)
+	{
+		return noarr::scalar<real_t>()
+			   ^ noarr::vectors<'v', 'c', 's', 'y', 'z'>(noarr::lit<lanes_>, get_chunk_len(problem.nx),
+														 substrates_count, problem.ny, problem.nz);
+	}
+
+	// The layout addressed by the grid coordinates, without the padding rows
+	static auto get_grid_layout(const problem_t<index_t, real_t>& problem)
+	{
+		return get_aosoa_layout(problem, problem.substrates_count) ^ noarr::merge_blocks<'v', 'c', 'x'>()
+			   ^ noarr::slice<'x'>(0, problem.nx);
+	}
+
+	static std::size_t get_padded_size(const problem_t<index_t, real_t>& problem)
+	{
+		return lanes_ * get_chunk_len(problem.nx) * problem.substrates_count * problem.ny * problem.nz;
+	}
+
+	void precompute_lane_values(lane_values_t& values, index_t shape, index_t dims, index_t n);
+
+	void solve_x_omp() override;
+	void solve_y_omp() override;
+	void solve_z_omp() override;
+
+public:
+	std::size_t allocated_elements(const max_problem_t& problem) const override
+	{
+		return get_padded_size(problems::cast<index_t, real_t>(problem));
+	}
+
+	void prepare(const max_problem_t& problem) override;
+
+	void initialize() override;
+
+	std::span<const std::byte> substrates_memory() const override;
+
+	double access(std::size_t s, std::size_t x, std::size_t y, std::size_t z) const override;
+};
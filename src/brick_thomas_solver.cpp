@@ -0,0 +1,182 @@
+#include "brick_thomas_solver.h"
+
+
+#include "solver_utils.h"
+
+template <typename real_t, typename index_t>
+void brick_thomas_solver<real_t, index_t>::tune(const nlohmann::json& params)
+{
+	base_t::tune(params);
+
+	brick_size_ = params.contains("brick_size") ? (index_t)params["brick_size"] : 8;
+}
+
+template <typename real_t, typename index_t>
+std::size_t brick_thomas_solver<real_t, index_t>::allocated_elements(const max_problem_t& problem) const
+{
+	// the bricks of prepare
+	const index_t brick_y = problem.dims >= 2 ? brick_size_ : 1;
+	const index_t brick_z = problem.dims >= 3 ? brick_size_ : 1;
+
+	return problem.substrates_count * brick_size_ * brick_y * brick_z * get_bricks((index_t)problem.nx, brick_size_)
+		   * get_bricks((index_t)problem.ny, brick_y) * get_bricks((index_t)problem.nz, brick_z);
+}
+
+template <typename real_t, typename index_t>
+void brick_thomas_solver<real_t, index_t>::prepare(const max_problem_t& problem)
+{
+	this->problem_ = problems::cast<index_t, real_t>(problem);
+
+	brick_x_ = brick_size_;
+	brick_y_ = this->problem_.dims >= 2 ? brick_size_ : 1;
+	brick_z_ = this->problem_.dims >= 3 ? brick_size_ : 1;
+
+	this->substrates_ = this->allocator_.template allocate<real_t>(get_bricked_size());
+
+	// Initialize substrates
+
+	auto brick_layout = get_brick_layout(this->problem_.substrates_count);
+
+	// zeroes also the padding of the bricks
+	if (this->problem_.dims == 3)
+		solver_utils::first_touch<'Z'>(brick_layout, this->substrates_.get(), this->work_items_);
+	else
+		solver_utils::first_touch<'Y'>(brick_layout, this->substrates_.get(), this->work_items_);
+
+	solver_utils::initialize_substrate(get_grid_layout(), this->substrates_.get(), this->problem_);
+}
+
+// Solves all lines of a brick column; the lines go along the bricks 'I' and the in-brick index 'i', the other two
+// in-brick dimensions are merged to 'm'. The padding lines of the partial bricks are solved as well, they stay zero.
+template <typename index_t, typename real_t, typename density_layout_t>
+inline void solve_brick_column(real_t* __restrict__ densities, const real_t* __restrict__ b,
+							   const real_t* __restrict__ c, const real_t* __restrict__ e,
+							   const density_layout_t dens_l, index_t n)
+{
+	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+	const index_t brick_len = dens_l | noarr::get_length<'i'>();
+	const index_t m_len = dens_l | noarr::get_length<'m'>();
+
+	auto diag_l = noarr::scalar<real_t>() ^ noarr::vector<'s'>(substrates_count) ^ noarr::vector<'i'>(n);
+
+	// the row g of the lines is the row g % brick_len of the brick g / brick_len
+	auto density = [=](index_t g, index_t m, index_t s) -> real_t& {
+		return dens_l | noarr::get_at<'I', 'i', 'm', 's'>(densities, g / brick_len, g % brick_len, m, s);
+	};
+
+	for (index_t g = 1; g < n; g++)
+	{
+		for (index_t m = 0; m < m_len; m++)
+		{
+#pragma omp simd
+			for (index_t s = 0; s < substrates_count; s++)
+			{
+				density(g, m, s) -= (diag_l | noarr::get_at<'i', 's'>(e, g - 1, s)) * density(g - 1, m, s);
+			}
+		}
+	}
+
+	for (index_t m = 0; m < m_len; m++)
+	{
+#pragma omp simd
+		for (index_t s = 0; s < substrates_count; s++)
+		{
+			density(n - 1, m, s) *= (diag_l | noarr::get_at<'i', 's'>(b, n - 1, s));
+		}
+	}
+
+	for (index_t g = n - 2; g >= 0; g--)
+	{
+		for (index_t m = 0; m < m_len; m++)
+		{
+#pragma omp simd
+			for (index_t s = 0; s < substrates_count; s++)
+			{
+				density(g, m, s) =
+					(density(g, m, s) - c[s] * density(g + 1, m, s)) * (diag_l | noarr::get_at<'i', 's'>(b, g, s));
+			}
+		}
+	}
+}
+
+// Distributes the brick columns, indexed by 'J' and 'K', among the threads
+template <typename index_t, typename real_t, typename density_layout_t>
+void solve_slice_bricks(real_t* __restrict__ densities, const real_t* __restrict__ b, const real_t* __restrict__ c,
+						const real_t* __restrict__ e, const density_layout_t dens_l, index_t n, std::size_t work_items)
+{
+	const index_t j_len = dens_l | noarr::get_length<'J'>();
+	const index_t k_len = dens_l | noarr::get_length<'K'>();
+
+#pragma omp for collapse(2) schedule(static, work_items)
+	for (index_t k = 0; k < k_len; k++)
+	{
+		for (index_t j = 0; j < j_len; j++)
+		{
+			solve_brick_column<index_t>(densities, b, c, e, dens_l ^ noarr::fix<'J'>(j) ^ noarr::fix<'K'>(k), n);
+		}
+	}
+}
+
+template <typename real_t, typename index_t>
+void brick_thomas_solver<real_t, index_t>::solve_x_omp()
+{
+	solver_utils::dispatch_substrates_count(
+		this->problem_.substrates_count, this->specialized_, [&](auto substrates_count) {
+			auto dens_l = get_brick_layout(substrates_count) ^ noarr::rename<'X', 'I', 'x', 'i', 'Y', 'J', 'Z', 'K'>()
+						  ^ noarr::merge_blocks<'z', 'y', 'm'>();
+
+			solve_slice_bricks<index_t>(this->substrates_.get(), this->bx_.get(), this->cx_.get(), this->ex_.get(),
+										dens_l, this->problem_.nx, this->work_items_);
+		});
+}
+
+template <typename real_t, typename index_t>
+void brick_thomas_solver<real_t, index_t>::solve_y_omp()
+{
+	if (this->problem_.dims < 2)
+		return;
+
+	solver_utils::dispatch_substrates_count(
+		this->problem_.substrates_count, this->specialized_, [&](auto substrates_count) {
+			auto dens_l = get_brick_layout(substrates_count) ^ noarr::rename<'Y', 'I', 'y', 'i', 'X', 'J', 'Z', 'K'>()
+						  ^ noarr::merge_blocks<'z', 'x', 'm'>();
+
+			solve_slice_bricks<index_t>(this->substrates_.get(), this->by_.get(), this->cy_.get(), this->ey_.get(),
+										dens_l, this->problem_.ny, this->work_items_);
+		});
+}
+
+template <typename real_t, typename index_t>
+void brick_thomas_solver<real_t, index_t>::solve_z_omp()
+{
+	if (this->problem_.dims < 3)
+		return;
+
+	solver_utils::dispatch_substrates_count(
+		this->problem_.substrates_count, this->specialized_, [&](auto substrates_count) {
+			auto dens_l = get_brick_layout(substrates_count) ^ noarr::rename<'Z', 'I', 'z', 'i', 'X', 'J', 'Y', 'K'>()
+						  ^ noarr::merge_blocks<'y', 'x', 'm'>();
+
+			solve_slice_bricks<index_t>(this->substrates_.get(), this->bz_.get(), this->cz_.get(), this->ez_.get(),
+										dens_l, this->problem_.nz, this->work_items_);
+		});
+}
+
+template <typename real_t, typename index_t>
+std::span<const std::byte> brick_thomas_solver<real_t, index_t>::substrates_memory() const
+{
+	return std::as_bytes(std::span(this->substrates_.get(), get_bricked_size()));
+}
+
+template <typename real_t, typename index_t>
+double brick_thomas_solver<real_t, index_t>::access(std::size_t s, std::size_t x, std::size_t y, std::size_t z) const
+{
+	auto dens_l = get_grid_layout();
+
+	return (dens_l | noarr::get_at<'s', 'x', 'y', 'z'>(this->substrates_.get(), s, x, y, z));
+}
+
+template class brick_thomas_solver<float, std::int32_t>;
+template class brick_thomas_solver<float, std::int64_t>;
+template class brick_thomas_solver<double, std::int32_t>;
+template class brick_thomas_solver<double, std::int64_t>;
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "least_compute_thomas_solver.h"
+
+/*
+The same solver as least_compute_thomas_solver, but the densities are stored in bricks of brick_size^3 points (the
+"brick_size" param, 8 by default; the bricks of 2D and 1D problems are flat). The points of a brick are stored
+together in the order s, x, y, z and the bricks in the order X, Y, Z, so each brick occupies a contiguous block of
+whole cache lines. The grid is padded to whole bricks, the padding stays zero.
+
+Each sweep walks columns of bricks along its dimension and solves all lines of a column at once, visiting the bricks
+in the order of the recurrence. So the x, y and z sweeps alike load whole bricks, instead of the z sweep striding by
+the size of an xy plane.
+*/
+
+template <typename real_t, typename index_t>
+class brick_thomas_solver : public least_compute_variant<real_t, index_t>
+{
+	using base_t = least_compute_variant<real_t, index_t>;
+
+	index_t brick_size_;
+
+	// the brick extents, 1 in the dimensions the problem does not have
+	index_t brick_x_, brick_y_, brick_z_;
+
+	static index_t get_bricks(index_t n, index_t brick_len) { return (n + brick_len - 1) / brick_len; }
+
+	// The in-brick dimensions are 'x', 'y', 'z', the brick dimensions are 'X', 'Y', 'Z'
+	// The substrates count is either index_t or noarr::lit for the specialized kernels
+	template <typename substrates_count_t>
+	auto get_brick_layout(substrates_count_t substrates_count) const
+	{
+		return noarr::scalar<real_t>()
+			   ^ noarr::vectors<'s', 'x', 'y', 'z', 'X', 'Y', 'Z'>(
+				   substrates_count, brick_x_, brick_y_, brick_z_, get_bricks(this->problem_.nx, brick_x_),
+				   get_bricks(this->problem_.ny, brick_y_), get_bricks(this->problem_.nz, brick_z_));
+	}
+
+	// The layout addressed by the grid coordinates, without the padding
+	auto get_grid_layout() const
+	{
+		return get_brick_layout(this->problem_.substrates_count) ^ noarr::merge_blocks<'X', 'x', 'p'>()
+			   ^ noarr::merge_blocks<'Y', 'y', 'q'>() ^ noarr::merge_blocks<'Z', 'z', 'r'>()
+			   ^ noarr::rename<'p', 'x', 'q', 'y', 'r', 'z'>() ^ noarr::slice<'x'>(0, this->problem_.nx)
+			   ^ noarr::slice<'y'>(0, this->problem_.ny) ^ noarr::slice<'z'>(0, this->problem_.nz);
+	}
+
+	std::size_t get_bricked_size() const
+	{
+		return (std::size_t)this->problem_.substrates_count * brick_x_ * brick_y_ * brick_z_
+			   * get_bricks(this->problem_.nx, brick_x_) * get_bricks(this->problem_.ny, brick_y_)
+			   * get_bricks(this->problem_.nz, brick_z_);
+	}
+
+	void solve_x_omp() override;
+	void solve_y_omp() override;
+	void solve_z_omp() override;
+
+public:
+	void tune(const nlohmann::json& params) override;
+
+	std::size_t allocated_elements(const max_problem_t& problem) const override;
+
+	void prepare(const max_problem_t& problem) override;
+
+	std::span<const std::byte> substrates_memory() const override;
+
+	double access(std::size_t s, std::size_t x, std::size_t y, std::size_t z) const override;
+};
@@ -0,0 +1,239 @@
+#include "compressed_thomas_solver.h"
+
+#include <algorithm>
+#include <cmath>
+
+template <typename real_t, typename index_t>
+void compressed_thomas_solver<real_t, index_t>::precompute_compressed_values(compressed_values_t& values,
+																			  index_t shape, index_t dims, index_t n)
+{
+	const index_t substrates_count = this->problem_.substrates_count;
+
+	// the full tables are computed as in least_compute_thomas_solver and only their unconverged rows are kept
+	aligned_buffer<real_t> b, c, e;
+	this->precompute_values(b, c, e, shape, dims, n, 1);
+
+	auto diag_l = noarr::scalar<real_t>() ^ noarr::vector<'s'>(substrates_count) ^ noarr::vector<'i'>(n);
+
+	// the first row whose diagonal differs from the previous one by less than the limit for all substrates
+	values.converged = std::max<index_t>(n - 2, 0);
+	for (index_t i = 1; i < n - 2; i++)
+	{
+		bool converged = true;
+		for (index_t s = 0; s < substrates_count; s++)
+			converged &= std::abs(1 / (diag_l | noarr::get_at<'i', 's'>(b.get(), i, s))
+								  - 1 / (diag_l | noarr::get_at<'i', 's'>(b.get(), i - 1, s)))
+						 < limit_threshold_;
+
+		if (converged)
+		{
+			values.converged = i;
+			break;
+		}
+	}
+
+	const index_t rows = values.converged + 1;
+
+	values.b = this->allocator_.template allocate<real_t>(rows * substrates_count);
+	values.e = this->allocator_.template allocate<real_t>(rows * substrates_count);
+	values.c = this->allocator_.template allocate<real_t>(substrates_count);
+	values.b_last = this->allocator_.template allocate<real_t>(substrates_count);
+
+	std::copy(b.get(), b.get() + rows * substrates_count, values.b.get());
+	std::copy(e.get(), e.get() + std::min(rows, n - 1) * substrates_count, values.e.get());
+	std::copy(c.get(), c.get() + substrates_count, values.c.get());
+	std::copy(b.get() + (n - 1) * substrates_count, b.get() + n * substrates_count, values.b_last.get());
+}
+
+template <typename real_t, typename index_t>
+void compressed_thomas_solver<real_t, index_t>::initialize()
+{
+	if (this->problem_.dims >= 1)
+		precompute_compressed_values(valuesx_, this->problem_.dx, this->problem_.dims, this->problem_.nx);
+	if (this->problem_.dims >= 2)
+		precompute_compressed_values(valuesy_, this->problem_.dy, this->problem_.dims, this->problem_.ny);
+	if (this->problem_.dims >= 3)
+		precompute_compressed_values(valuesz_, this->problem_.dz, this->problem_.dims, this->problem_.nz);
+}
+
+// Solves the x line yz; the row of the coefficient tables is selected once per i, so the inner loop is the same as in
+// solve_line_x
+template <typename index_t, typename real_t, typename density_layout_t>
+inline void solve_line_x_compressed(real_t* __restrict__ densities, const real_t* __restrict__ b,
+									const real_t* __restrict__ c, const real_t* __restrict__ e,
+									const real_t* __restrict__ b_last, index_t converged,
+									const density_layout_t dens_l, index_t yz)
+{
+	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+	const index_t n = dens_l | noarr::get_length<'x'>();
+
+	auto diag_l = noarr::scalar<real_t>() ^ noarr::vector<'s'>(substrates_count) ^ noarr::vector<'i'>(converged + 1);
+
+	for (index_t i = 1; i < n; i++)
+	{
+		const index_t row = std::min(i - 1, converged);
+
+#pragma omp simd
+		for (index_t s = 0; s < substrates_count; s++)
+		{
+			(dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i, s)) =
+				(dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i, s))
+				- (diag_l | noarr::get_at<'i', 's'>(e, row, s))
+					  * (dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i - 1, s));
+		}
+	}
+
+#pragma omp simd
+	for (index_t s = 0; s < substrates_count; s++)
+	{
+		(dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, n - 1, s)) =
+			(dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, n - 1, s)) * b_last[s];
+	}
+
+	for (index_t i = n - 2; i >= 0; i--)
+	{
+		const index_t row = std::min(i, converged);
+
+#pragma omp simd
+		for (index_t s = 0; s < substrates_count; s++)
+		{
+			(dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i, s)) =
+				((dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i, s))
+				 - c[s] * (dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i + 1, s)))
+				* (diag_l | noarr::get_at<'i', 's'>(b, row, s));
+		}
+	}
+}
+
+// Solves the y lines of the z slab going through the x range [x_begin, x_end)
+template <typename index_t, typename real_t, typename density_layout_t>
+inline void solve_slab_y_compressed(real_t* __restrict__ densities, const real_t* __restrict__ b,
+									const real_t* __restrict__ c, const real_t* __restrict__ e,
+									const real_t* __restrict__ b_last, index_t converged,
+									const density_layout_t dens_l, index_t z, index_t x_begin, index_t x_end)
+{
+	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+	const index_t n = dens_l | noarr::get_length<'y'>();
+
+	auto diag_l = noarr::scalar<real_t>() ^ noarr::vector<'s'>(substrates_count) ^ noarr::vector<'i'>(converged + 1);
+
+	for (index_t i = 1; i < n; i++)
+	{
+		const index_t row = std::min(i - 1, converged);
+
+		for (index_t x = x_begin; x < x_end; x++)
+		{
+#pragma omp simd
+			for (index_t s = 0; s < substrates_count; s++)
+			{
+				(dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, z, i, x, s)) =
+					(dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, z, i, x, s))
+					- (diag_l | noarr::get_at<'i', 's'>(e, row, s))
+						  * (dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, z, i - 1, x, s));
+			}
+		}
+	}
+
+	for (index_t x = x_begin; x < x_end; x++)
+	{
+#pragma omp simd
+		for (index_t s = 0; s < substrates_count; s++)
+		{
+			(dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, z, n - 1, x, s)) =
+				(dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, z, n - 1, x, s)) * b_last[s];
+		}
+	}
+
+	for (index_t i = n - 2; i >= 0; i--)
+	{
+		const index_t row = std::min(i, converged);
+
+		for (index_t x = x_begin; x < x_end; x++)
+		{
+#pragma omp simd
+			for (index_t s = 0; s < substrates_count; s++)
+			{
+				(dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, z, i, x, s)) =
+					((dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, z, i, x, s))
+					 - c[s] * (dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, z, i + 1, x, s)))
+					* (diag_l | noarr::get_at<'i', 's'>(b, row, s));
+			}
+		}
+	}
+}
+
+// Solves the z lines going through the y row
+template <typename index_t, typename real_t, typename density_layout_t>
+inline void solve_row_z_compressed(real_t* __restrict__ densities, const real_t* __restrict__ b,
+								   const real_t* __restrict__ c, const real_t* __restrict__ e,
+								   const real_t* __restrict__ b_last, index_t converged,
+								   const density_layout_t dens_l, index_t y)
+{
+	auto row_l = dens_l ^ noarr::rename<'z', 'y', 'y', 'z'>();
+
+	solve_slab_y_compressed<index_t>(densities, b, c, e, b_last, converged, row_l, y, 0,
+									 (index_t)(row_l | noarr::get_length<'x'>()));
+}
+
+template <typename real_t, typename index_t>
+void compressed_thomas_solver<real_t, index_t>::solve_x_omp()
+{
+	auto dens_l = base_t::template get_substrates_layout<3>(this->problem_) ^ noarr::merge_blocks<'z', 'y', 'm'>();
+
+	const index_t m = dens_l | noarr::get_length<'m'>();
+
+#pragma omp for schedule(static, this->work_items_)
+	for (index_t yz = 0; yz < m; yz++)
+	{
+		solve_line_x_compressed<index_t>(this->substrates_.get(), valuesx_.b.get(), valuesx_.c.get(),
+										 valuesx_.e.get(), valuesx_.b_last.get(), valuesx_.converged, dens_l, yz);
+	}
+}
+
+template <typename real_t, typename index_t>
+void compressed_thomas_solver<real_t, index_t>::solve_y_omp()
+{
+	if (this->problem_.dims < 2)
+		return;
+
+	auto dens_l = base_t::template get_substrates_layout<3>(this->problem_);
+
+	const index_t z_len = this->problem_.nz;
+	const index_t x_len = this->problem_.nx;
+
+	const index_t x_blocks = this->get_slab_blocks(x_len);
+
+#pragma omp for collapse(2) schedule(static, this->work_items_)
+	for (index_t z = 0; z < z_len; z++)
+	{
+		for (index_t block = 0; block < x_blocks; block++)
+		{
+			solve_slab_y_compressed<index_t>(this->substrates_.get(), valuesy_.b.get(), valuesy_.c.get(),
+											 valuesy_.e.get(), valuesy_.b_last.get(), valuesy_.converged, dens_l, z,
+											 block * x_len / x_blocks, (block + 1) * x_len / x_blocks);
+		}
+	}
+}
+
+template <typename real_t, typename index_t>
+void compressed_thomas_solver<real_t, index_t>::solve_z_omp()
+{
+	if (this->problem_.dims < 3)
+		return;
+
+	auto dens_l = base_t::template get_substrates_layout<3>(this->problem_);
+
+	const index_t y_len = this->problem_.ny;
+
+#pragma omp for schedule(static, this->work_items_)
+	for (index_t y = 0; y < y_len; y++)
+	{
+		solve_row_z_compressed<index_t>(this->substrates_.get(), valuesz_.b.get(), valuesz_.c.get(),
+										valuesz_.e.get(), valuesz_.b_last.get(), valuesz_.converged, dens_l, y);
+	}
+}
+
+template class compressed_thomas_solver<float, std::int32_t>;
+template class compressed_thomas_solver<float, std::int64_t>;
+template class compressed_thomas_solver<double, std::int32_t>;
+template class compressed_thomas_solver<double, std::int64_t>;
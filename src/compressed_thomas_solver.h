@@ -0,0 +1,46 @@
+#pragma once
+
+#include <type_traits>
+
+#include "least_compute_thomas_solver.h"
+
+/*
+The same solver as least_compute_thomas_solver, but the precomputed b' and e values are stored only up to the index
+where b' converges (as in least_memory_thomas_solver, where the diagonal stops changing by more than the limit). All
+later rows use the values of the converged row, except b'_n, which differs due to the boundary and is stored
+separately. So the inner loops stay without divisions, while the coefficient tables shrink from n rows to a few
+rows, leaving the cache to the densities.
+
+The converged index is shared by all substrates, so the rows stay vectorizable over the substrates.
+*/
+
+template <typename real_t, typename index_t>
+class compressed_thomas_solver : public least_compute_variant<real_t, index_t>
+{
+	using base_t = least_compute_variant<real_t, index_t>;
+
+	static constexpr real_t limit_threshold_ = std::is_same_v<real_t, float> ? 1e-6f : 1e-12;
+
+	struct compressed_values_t
+	{
+		// the last stored row, the rows after it (up to n - 2) are the same
+		index_t converged;
+
+		// (converged + 1) x substrates_count
+		aligned_buffer<real_t> b, e;
+
+		// substrates_count
+		aligned_buffer<real_t> c, b_last;
+	};
+
+	compressed_values_t valuesx_, valuesy_, valuesz_;
+
+	void precompute_compressed_values(compressed_values_t& values, index_t shape, index_t dims, index_t n);
+
+	void solve_x_omp() override;
+	void solve_y_omp() override;
+	void solve_z_omp() override;
+
+public:
+	void initialize() override;
+};
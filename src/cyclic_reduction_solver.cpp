@@ -0,0 +1,377 @@
+#include "cyclic_reduction_solver.h"
+
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+
+#include "solver_utils.h"
+
+template <typename index_t>
+static index_t get_levels_count(index_t n)
+{
+	index_t levels = 0;
+	for (index_t stride = 1; stride < n; stride *= 2)
+		levels++;
+	return levels;
+}
+
+template <typename real_t, typename index_t>
+void cyclic_reduction_solver<real_t, index_t>::precompute_values(aligned_buffer<real_t>& alpha,
+																 aligned_buffer<real_t>& gamma,
+																 aligned_buffer<real_t>& binv, index_t shape,
+																 index_t dims, index_t n)
+{
+	const index_t levels = get_levels_count(n);
+
+	alpha = allocator_.allocate<real_t>(n * problem_.substrates_count * levels);
+	gamma = allocator_.allocate<real_t>(n * problem_.substrates_count * levels);
+	binv = allocator_.allocate<real_t>(n * problem_.substrates_count);
+
+	auto a = std::make_unique<real_t[]>(n * problem_.substrates_count);
+	auto b = std::make_unique<real_t[]>(n * problem_.substrates_count);
+	auto c = std::make_unique<real_t[]>(n * problem_.substrates_count);
+
+	auto a_next = std::make_unique<real_t[]>(n * problem_.substrates_count);
+	auto b_next = std::make_unique<real_t[]>(n * problem_.substrates_count);
+	auto c_next = std::make_unique<real_t[]>(n * problem_.substrates_count);
+
+	auto diag_l = noarr::scalar<real_t>() ^ noarr::vectors<'s', 'i'>(problem_.substrates_count, n);
+	auto coef_l = noarr::scalar<real_t>() ^ noarr::vectors<'s', 'i', 'l'>(problem_.substrates_count, n, levels);
+
+	// compute a_i, b_i, c_i
+	for (index_t i = 0; i < n; i++)
+		for (index_t s = 0; s < problem_.substrates_count; s++)
+		{
+			const real_t r = problem_.dt * problem_.diffusion_coefficients[s] / (shape * shape);
+
+			(diag_l | noarr::get_at<'i', 's'>(a.get(), i, s)) = i == 0 ? 0 : -r;
+			(diag_l | noarr::get_at<'i', 's'>(c.get(), i, s)) = i == n - 1 ? 0 : -r;
+			(diag_l | noarr::get_at<'i', 's'>(b.get(), i, s)) =
+				1 + problem_.decay_rates[s] * problem_.dt / dims + ((i == 0 || i == n - 1) ? r : 2 * r);
+		}
+
+	// compute alpha_i, gamma_i of each level and reduce the system
+	for (index_t level = 0, stride = 1; stride < n; level++, stride *= 2)
+	{
+		for (index_t i = 0; i < n; i++)
+			for (index_t s = 0; s < problem_.substrates_count; s++)
+			{
+				real_t alpha_i = 0, gamma_i = 0;
+				real_t a_i = 0, c_i = 0;
+				real_t b_i = (diag_l | noarr::get_at<'i', 's'>(b.get(), i, s));
+
+				if (i >= stride)
+				{
+					alpha_i = (diag_l | noarr::get_at<'i', 's'>(a.get(), i, s))
+							  / (diag_l | noarr::get_at<'i', 's'>(b.get(), i - stride, s));
+					a_i = -alpha_i * (diag_l | noarr::get_at<'i', 's'>(a.get(), i - stride, s));
+					b_i -= alpha_i * (diag_l | noarr::get_at<'i', 's'>(c.get(), i - stride, s));
+				}
+
+				if (i + stride < n)
+				{
+					gamma_i = (diag_l | noarr::get_at<'i', 's'>(c.get(), i, s))
+							  / (diag_l | noarr::get_at<'i', 's'>(b.get(), i + stride, s));
+					c_i = -gamma_i * (diag_l | noarr::get_at<'i', 's'>(c.get(), i + stride, s));
+					b_i -= gamma_i * (diag_l | noarr::get_at<'i', 's'>(a.get(), i + stride, s));
+				}
+
+				(coef_l | noarr::get_at<'l', 'i', 's'>(alpha.get(), level, i, s)) = alpha_i;
+				(coef_l | noarr::get_at<'l', 'i', 's'>(gamma.get(), level, i, s)) = gamma_i;
+
+				(diag_l | noarr::get_at<'i', 's'>(a_next.get(), i, s)) = a_i;
+				(diag_l | noarr::get_at<'i', 's'>(b_next.get(), i, s)) = b_i;
+				(diag_l | noarr::get_at<'i', 's'>(c_next.get(), i, s)) = c_i;
+			}
+
+		std::swap(a, a_next);
+		std::swap(b, b_next);
+		std::swap(c, c_next);
+	}
+
+	// compute 1/b_i of the final diagonal system
+	for (index_t i = 0; i < n; i++)
+		for (index_t s = 0; s < problem_.substrates_count; s++)
+			(diag_l | noarr::get_at<'i', 's'>(binv.get(), i, s)) =
+				1 / (diag_l | noarr::get_at<'i', 's'>(b.get(), i, s));
+}
+
+template <typename real_t, typename index_t>
+void cyclic_reduction_solver<real_t, index_t>::prepare(const max_problem_t& problem)
+{
+	problem_ = problems::cast<index_t, real_t>(problem);
+	substrates_ = allocator_.allocate<real_t>(problem_.nx * problem_.ny * problem_.nz * problem_.substrates_count);
+
+	// Initialize substrates
+
+	auto substrates_layout = get_substrates_layout<3>(problem_);
+
+	solver_utils::initialize_substrate(substrates_layout, substrates_.get(), problem_);
+}
+
+template <typename real_t, typename index_t>
+void cyclic_reduction_solver<real_t, index_t>::tune(const nlohmann::json& params)
+{
+	allocator_.tune(params);
+
+	work_items_ = params.contains("work_items") ? (std::size_t)params["work_items"] : 1;
+}
+
+template <typename real_t, typename index_t>
+void cyclic_reduction_solver<real_t, index_t>::initialize()
+{
+	scratchpad_ = allocator_.allocate<real_t>(problem_.nx * problem_.ny * problem_.nz * problem_.substrates_count);
+
+	if (problem_.dims >= 1)
+		precompute_values(alphax_, gammax_, binvx_, problem_.dx, problem_.dims, problem_.nx);
+	if (problem_.dims >= 2)
+		precompute_values(alphay_, gammay_, binvy_, problem_.dy, problem_.dims, problem_.ny);
+	if (problem_.dims >= 3)
+		precompute_values(alphaz_, gammaz_, binvz_, problem_.dz, problem_.dims, problem_.nz);
+}
+
+template <typename real_t, typename index_t>
+template <std::size_t dims>
+auto cyclic_reduction_solver<real_t, index_t>::get_substrates_layout(const problem_t<index_t, real_t>& problem)
+{
+	if constexpr (dims == 1)
+		return noarr::scalar<real_t>() ^ noarr::vectors<'s', 'x'>(problem.substrates_count, problem.nx);
+	else if constexpr (dims == 2)
+		return noarr::scalar<real_t>()
+			   ^ noarr::vectors<'s', 'x', 'y'>(problem.substrates_count, problem.nx, problem.ny);
+	else if constexpr (dims == 3)
+		return noarr::scalar<real_t>()
+			   ^ noarr::vectors<'s', 'x', 'y', 'z'>(problem.substrates_count, problem.nx, problem.ny, problem.nz);
+}
+
+// One reduction level of a single line, where the line and the substrates are merged into a single dimension 'j'.
+// The coefficients share the layout of the line, so threads and SIMD lanes split the line itself.
+template <typename index_t, typename real_t, typename density_layout_t>
+void solve_level_1d(const real_t* __restrict__ src, real_t* __restrict__ dst, const real_t* __restrict__ alpha,
+					const real_t* __restrict__ gamma, const density_layout_t dens_l, index_t stride)
+{
+	const index_t len = dens_l | noarr::get_length<'j'>();
+
+#pragma omp for simd schedule(static)
+	for (index_t j = 0; j < len; j++)
+	{
+		real_t value = (dens_l | noarr::get_at<'j'>(src, j));
+
+		if (j >= stride)
+			value -= alpha[j] * (dens_l | noarr::get_at<'j'>(src, j - stride));
+
+		if (j + stride < len)
+			value -= gamma[j] * (dens_l | noarr::get_at<'j'>(src, j + stride));
+
+		(dens_l | noarr::get_at<'j'>(dst, j)) = value;
+	}
+}
+
+template <typename index_t, typename real_t, typename density_layout_t>
+void solve_slice_x_1d(real_t* __restrict__ densities, real_t* __restrict__ scratchpad, const real_t* __restrict__ alpha,
+					  const real_t* __restrict__ gamma, const real_t* __restrict__ binv, const density_layout_t dens_l)
+{
+	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+	const index_t n = dens_l | noarr::get_length<'x'>();
+
+	auto line_l = dens_l ^ noarr::merge_blocks<'x', 's', 'j'>();
+
+	real_t* src = densities;
+	real_t* dst = scratchpad;
+
+	for (index_t level = 0, stride = 1; stride < n; level++, stride *= 2)
+	{
+		solve_level_1d<index_t>(src, dst, alpha + level * n * substrates_count, gamma + level * n * substrates_count,
+								line_l, stride * substrates_count);
+
+		std::swap(src, dst);
+	}
+
+	const index_t len = n * substrates_count;
+
+#pragma omp for simd schedule(static)
+	for (index_t j = 0; j < len; j++)
+		(line_l | noarr::get_at<'j'>(densities, j)) = (line_l | noarr::get_at<'j'>(src, j)) * binv[j];
+}
+
+// One reduction level of the lines along 'i'; 'q' and 'm' enumerate the lines inside and outside of 'i' respectively
+template <typename index_t, typename real_t, typename density_layout_t>
+void solve_level(const real_t* __restrict__ src, real_t* __restrict__ dst, const real_t* __restrict__ alpha,
+				 const real_t* __restrict__ gamma, const density_layout_t dens_l, index_t stride,
+				 std::size_t work_items)
+{
+	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+	const index_t n = dens_l | noarr::get_length<'i'>();
+	const index_t q_len = dens_l | noarr::get_length<'q'>();
+	const index_t m_len = dens_l | noarr::get_length<'m'>();
+
+	auto diag_l = noarr::scalar<real_t>() ^ noarr::vectors<'s', 'i'>(substrates_count, n);
+
+#pragma omp for collapse(2) schedule(static, work_items)
+	for (index_t m = 0; m < m_len; m++)
+	{
+		for (index_t i = 0; i < n; i++)
+		{
+			for (index_t q = 0; q < q_len; q++)
+			{
+#pragma omp simd
+				for (index_t s = 0; s < substrates_count; s++)
+				{
+					real_t value = (dens_l | noarr::get_at<'m', 'i', 'q', 's'>(src, m, i, q, s));
+
+					if (i >= stride)
+						value -= (diag_l | noarr::get_at<'i', 's'>(alpha, i, s))
+								 * (dens_l | noarr::get_at<'m', 'i', 'q', 's'>(src, m, i - stride, q, s));
+
+					if (i + stride < n)
+						value -= (diag_l | noarr::get_at<'i', 's'>(gamma, i, s))
+								 * (dens_l | noarr::get_at<'m', 'i', 'q', 's'>(src, m, i + stride, q, s));
+
+					(dens_l | noarr::get_at<'m', 'i', 'q', 's'>(dst, m, i, q, s)) = value;
+				}
+			}
+		}
+	}
+}
+
+template <typename index_t, typename real_t, typename density_layout_t>
+void solve_slice(real_t* __restrict__ densities, real_t* __restrict__ scratchpad, const real_t* __restrict__ alpha,
+				 const real_t* __restrict__ gamma, const real_t* __restrict__ binv, const density_layout_t dens_l,
+				 std::size_t work_items)
+{
+	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+	const index_t n = dens_l | noarr::get_length<'i'>();
+	const index_t q_len = dens_l | noarr::get_length<'q'>();
+	const index_t m_len = dens_l | noarr::get_length<'m'>();
+
+	auto diag_l = noarr::scalar<real_t>() ^ noarr::vectors<'s', 'i'>(substrates_count, n);
+
+	real_t* src = densities;
+	real_t* dst = scratchpad;
+
+	for (index_t level = 0, stride = 1; stride < n; level++, stride *= 2)
+	{
+		solve_level<index_t>(src, dst, alpha + level * n * substrates_count, gamma + level * n * substrates_count,
+							 dens_l, stride, work_items);
+
+		std::swap(src, dst);
+	}
+
+#pragma omp for collapse(2) schedule(static, work_items)
+	for (index_t m = 0; m < m_len; m++)
+	{
+		for (index_t i = 0; i < n; i++)
+		{
+			for (index_t q = 0; q < q_len; q++)
+			{
+#pragma omp simd
+				for (index_t s = 0; s < substrates_count; s++)
+				{
+					(dens_l | noarr::get_at<'m', 'i', 'q', 's'>(densities, m, i, q, s)) =
+						(dens_l | noarr::get_at<'m', 'i', 'q', 's'>(src, m, i, q, s))
+						* (diag_l | noarr::get_at<'i', 's'>(binv, i, s));
+				}
+			}
+		}
+	}
+}
+
+template <typename real_t, typename index_t>
+void cyclic_reduction_solver<real_t, index_t>::solve_x()
+{
+	if (problem_.dims == 1)
+	{
+#pragma omp parallel
+		solve_slice_x_1d<index_t>(substrates_.get(), scratchpad_.get(), alphax_.get(), gammax_.get(), binvx_.get(),
+								  get_substrates_layout<1>(problem_));
+	}
+	else if (problem_.dims == 2)
+	{
+#pragma omp parallel
+		solve_slice<index_t>(substrates_.get(), scratchpad_.get(), alphax_.get(), gammax_.get(), binvx_.get(),
+							 get_substrates_layout<2>(problem_) ^ noarr::rename<'x', 'i', 'y', 'm'>()
+								 ^ noarr::vector<'q'>(1),
+							 work_items_);
+	}
+	else if (problem_.dims == 3)
+	{
+#pragma omp parallel
+		solve_slice<index_t>(substrates_.get(), scratchpad_.get(), alphax_.get(), gammax_.get(), binvx_.get(),
+							 get_substrates_layout<3>(problem_) ^ noarr::rename<'x', 'i'>()
+								 ^ noarr::merge_blocks<'z', 'y', 'm'>() ^ noarr::vector<'q'>(1),
+							 work_items_);
+	}
+}
+
+template <typename real_t, typename index_t>
+void cyclic_reduction_solver<real_t, index_t>::solve_y()
+{
+	if (problem_.dims == 2)
+	{
+#pragma omp parallel
+		solve_slice<index_t>(substrates_.get(), scratchpad_.get(), alphay_.get(), gammay_.get(), binvy_.get(),
+							 get_substrates_layout<2>(problem_) ^ noarr::rename<'x', 'q', 'y', 'i'>()
+								 ^ noarr::vector<'m'>(1),
+							 work_items_);
+	}
+	else if (problem_.dims == 3)
+	{
+#pragma omp parallel
+		solve_slice<index_t>(substrates_.get(), scratchpad_.get(), alphay_.get(), gammay_.get(), binvy_.get(),
+							 get_substrates_layout<3>(problem_) ^ noarr::rename<'x', 'q', 'y', 'i', 'z', 'm'>(),
+							 work_items_);
+	}
+}
+
+template <typename real_t, typename index_t>
+void cyclic_reduction_solver<real_t, index_t>::solve_z()
+{
+	if (problem_.dims == 3)
+	{
+#pragma omp parallel
+		solve_slice<index_t>(substrates_.get(), scratchpad_.get(), alphaz_.get(), gammaz_.get(), binvz_.get(),
+							 get_substrates_layout<3>(problem_) ^ noarr::rename<'z', 'i'>()
+								 ^ noarr::merge_blocks<'y', 'x', 'q'>() ^ noarr::vector<'m'>(1),
+							 work_items_);
+	}
+}
+
+template <typename real_t, typename index_t>
+void cyclic_reduction_solver<real_t, index_t>::save(const std::string& file) const
+{
+	auto dens_l = get_substrates_layout<3>(problem_);
+
+	std::ofstream out(file);
+
+	for (index_t z = 0; z < problem_.nz; z++)
+		for (index_t y = 0; y < problem_.ny; y++)
+			for (index_t x = 0; x < problem_.nx; x++)
+			{
+				for (index_t s = 0; s < problem_.substrates_count; s++)
+					out << (dens_l | noarr::get_at<'s', 'x', 'y', 'z'>(substrates_.get(), s, x, y, z)) << " ";
+				out << std::endl;
+			}
+
+	out.close();
+}
+
+template <typename real_t, typename index_t>
+std::span<const std::byte> cyclic_reduction_solver<real_t, index_t>::substrates_memory() const
+{
+	return std::as_bytes(
+		std::span(substrates_.get(), problem_.nx * problem_.ny * problem_.nz * problem_.substrates_count));
+}
+
+template <typename real_t, typename index_t>
+double cyclic_reduction_solver<real_t, index_t>::access(std::size_t s, std::size_t x, std::size_t y,
+														std::size_t z) const
+{
+	auto dens_l = get_substrates_layout<3>(problem_);
+
+	return (dens_l | noarr::get_at<'s', 'x', 'y', 'z'>(substrates_.get(), s, x, y, z));
+}
+
+template class cyclic_reduction_solver<float, std::int32_t>;
+template class cyclic_reduction_solver<float, std::int64_t>;
+template class cyclic_reduction_solver<double, std::int32_t>;
+template class cyclic_reduction_solver<double, std::int64_t>;
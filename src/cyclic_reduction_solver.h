@@ -0,0 +1,76 @@
+#pragma once
+
+#include <memory>
+
+#include <noarr/structures_extended.hpp>
+
+#include "aligned_allocator.h"
+#include "tridiagonal_solver.h"
+
+/*
+The diffusion is the problem of solving tridiagonal matrix system with these coeficients:
+For dimension x:
+a_i  == -dt*diffusion_coefs/dx^2                              1 <  i <= n
+b_1  == 1 + dt*decay_rates/dims + dt*diffusion_coefs/dx^2
+b_i  == 1 + dt*decay_rates/dims + 2*dt*diffusion_coefs/dx^2   1 <  i <  n
+b_n  == 1 + dt*decay_rates/dims + dt*diffusion_coefs/dx^2
+c_i  == -dt*diffusion_coefs/dx^2                              1 <= i <  n
+d_i  == current diffusion rates
+For dimension y/z (if they exist):
+substitute dx accordingly to dy/dz
+
+Parallel cyclic reduction eliminates the couplings of each equation to its neighbours at distance k (k = 1, 2, 4, ...).
+In one level, every equation i is combined with equations i-k and i+k:
+alpha_i == a_i/b_(i-k)
+gamma_i == c_i/b_(i+k)
+a_i'    == -alpha_i*a_(i-k)
+b_i'    == b_i - alpha_i*c_(i-k) - gamma_i*a_(i+k)
+c_i'    == -gamma_i*c_(i+k)
+d_i'    == d_i - alpha_i*d_(i-k) - gamma_i*d_(i+k)
+where the terms with out-of-range indices are zero. After ceil(log2(n)) levels the system is diagonal.
+
+Since the matrix is constant for multiple right hand sides, we precompute alpha_i and gamma_i for each level and 1/b_i
+of the final diagonal system. Then, the solve consists of ceil(log2(n)) levels of (2n multiplications + 2n subtractions)
+and the final n multiplications. Each level is fully parallel in i, so even a single long line can be split across
+threads and SIMD lanes.
+*/
+
+template <typename real_t, typename index_t>
+class cyclic_reduction_solver : public tridiagonal_solver
+{
+	problem_t<index_t, real_t> problem_;
+
+	aligned_allocator allocator_;
+
+	aligned_buffer<real_t> substrates_;
+	aligned_buffer<real_t> scratchpad_;
+
+	aligned_buffer<real_t> alphax_, gammax_, binvx_;
+	aligned_buffer<real_t> alphay_, gammay_, binvy_;
+	aligned_buffer<real_t> alphaz_, gammaz_, binvz_;
+
+	std::size_t work_items_;
+
+	void precompute_values(aligned_buffer<real_t>& alpha, aligned_buffer<real_t>& gamma, aligned_buffer<real_t>& binv,
+						   index_t shape, index_t dims, index_t n);
+
+	template <std::size_t dims>
+	static auto get_substrates_layout(const problem_t<index_t, real_t>& problem);
+
+public:
+	void prepare(const max_problem_t& problem) override;
+
+	void tune(const nlohmann::json& params) override;
+
+	void initialize() override;
+
+	void solve_x() override;
+	void solve_y() override;
+	void solve_z() override;
+
+	void save(const std::string& file) const override;
+
+	std::span<const std::byte> substrates_memory() const override;
+
+	double access(std::size_t s, std::size_t x, std::size_t y, std::size_t z) const override;
+};
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstddef>
+#include <span>
+
 #include <nlohmann/json.hpp>
 
 #include "problem.h"
@@ -7,23 +10,40 @@
 class diffusion_solver
 {
 public:
+	// Sets the solver specific parameters (called first, so the parameters can drive the allocation)
+	virtual void tune(const nlohmann::json&) {};
+
+	// Returns the number of the density elements the solver allocates for the problem, including any padding (called
+	// after tune, before prepare), so the index width can be chosen before the allocation
+	virtual std::size_t allocated_elements(const max_problem_t& problem) const
+	{
+		return problem.nx * problem.ny * problem.nz * problem.substrates_count;
+	}
+
 	// Allocates common resources
 	virtual void prepare(const max_problem_t& problem) = 0;
 
-	// Sets the solver specific parameters
-	virtual void tune(const nlohmann::json&) {};
-
 	// Allocates solver specific resources
 	virtual void initialize() = 0;
 
 	// Solves the diffusion problem
 	virtual void solve() = 0;
 
+	// Solves the diffusion problem for the given number of time steps
+	virtual void solve_iterations(std::size_t iterations)
+	{
+		for (std::size_t i = 0; i < iterations; i++)
+			solve();
+	}
+
 	// Saves data to a file in human readable format with the following structure:
 	// Each line contains a space-separated list of values for a single point in the grid (so all substrates)
 	// The points are ordered in x, y, z order
 	virtual void save(const std::string& file) const = 0;
 
+	// Returns the memory holding the substrates, e.g. to inspect its placement to NUMA nodes
+	virtual std::span<const std::byte> substrates_memory() const { return {}; }
+
 	// Accesses the value at the given coordinates
 	virtual double access(std::size_t s, std::size_t x, std::size_t y, std::size_t z) const = 0;
 
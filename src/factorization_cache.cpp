@@ -0,0 +1,154 @@
+#include "factorization_cache.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+// The entries are shared, so a lookup holds the lock only to copy the pointer and the data is copied outside it
+using entry_t = std::shared_ptr<const std::vector<std::byte>>;
+
+// The entries of all solvers in the process
+static std::mutex entries_mutex;
+static std::unordered_map<std::string, entry_t> entries;
+
+template <typename byte_t>
+static std::size_t get_total_size(std::initializer_list<std::span<byte_t>> buffers)
+{
+	std::size_t size = 0;
+	for (auto buffer : buffers)
+		size += buffer.size();
+
+	return size;
+}
+
+// Reads the entry of the key from the file, returns null if the file is missing or starts with another key (a hash
+// collision)
+static entry_t read_entry_file(const std::string& path, const std::string& key)
+{
+	std::ifstream in(path, std::ios::binary);
+
+	std::uint64_t key_size = 0, data_size = 0;
+	if (!in.read(reinterpret_cast<char*>(&key_size), sizeof(key_size)) || key_size != key.size())
+		return nullptr;
+
+	std::string file_key(key_size, '\0');
+	if (!in.read(file_key.data(), key_size) || file_key != key
+		|| !in.read(reinterpret_cast<char*>(&data_size), sizeof(data_size)))
+		return nullptr;
+
+	auto data = std::make_shared<std::vector<std::byte>>(data_size);
+	if (!in.read(reinterpret_cast<char*>(data->data()), data_size))
+		return nullptr;
+
+	return data;
+}
+
+void factorization_cache::tune(const nlohmann::json& params)
+{
+	enabled_ = params.contains("factorization_cache") ? (bool)params["factorization_cache"] : false;
+	directory_ = params.contains("factorization_cache_dir") ? (std::string)params["factorization_cache_dir"] : "";
+
+	if (enabled_ && !directory_.empty())
+	{
+		std::error_code ec;
+		std::filesystem::create_directories(directory_, ec);
+
+		if (ec)
+			throw std::runtime_error("Unable to create the factorization cache directory " + directory_ + ": "
+									 + ec.message());
+	}
+}
+
+std::string factorization_cache::get_file_path(const std::string& key) const
+{
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016zx.bin", std::hash<std::string> {}(key));
+
+	return (std::filesystem::path(directory_) / name).string();
+}
+
+bool factorization_cache::load(const std::string& key, std::initializer_list<std::span<std::byte>> buffers) const
+{
+	if (!enabled_)
+		return false;
+
+	entry_t entry;
+
+	{
+		std::lock_guard lock(entries_mutex);
+
+		if (auto it = entries.find(key); it != entries.end())
+			entry = it->second;
+	}
+
+	// the file is read outside the lock; if another thread has read it meanwhile, its entry is kept
+	if (!entry && !directory_.empty())
+	{
+		entry = read_entry_file(get_file_path(key), key);
+
+		if (entry)
+		{
+			std::lock_guard lock(entries_mutex);
+			entry = entries.try_emplace(key, entry).first->second;
+		}
+	}
+
+	if (!entry || entry->size() != get_total_size(buffers))
+		return false;
+
+	const std::byte* data = entry->data();
+	for (auto buffer : buffers)
+	{
+		std::memcpy(buffer.data(), data, buffer.size());
+		data += buffer.size();
+	}
+
+	return true;
+}
+
+void factorization_cache::store(const std::string& key,
+								std::initializer_list<std::span<const std::byte>> buffers) const
+{
+	if (!enabled_)
+		return;
+
+	auto data = std::make_shared<std::vector<std::byte>>();
+	data->reserve(get_total_size(buffers));
+
+	for (auto buffer : buffers)
+		data->insert(data->end(), buffer.begin(), buffer.end());
+
+	if (!directory_.empty())
+	{
+		// written under a temporary name first, so concurrent runs never read a partial file
+		const std::string path = get_file_path(key);
+		const std::string tmp_path = path + ".tmp" + std::to_string(std::random_device {}());
+
+		{
+			std::ofstream out(tmp_path, std::ios::binary);
+
+			const std::uint64_t key_size = key.size(), data_size = data->size();
+			out.write(reinterpret_cast<const char*>(&key_size), sizeof(key_size));
+			out.write(key.data(), key_size);
+			out.write(reinterpret_cast<const char*>(&data_size), sizeof(data_size));
+			out.write(reinterpret_cast<const char*>(data->data()), data_size);
+
+			if (!out)
+				throw std::runtime_error("Unable to write the factorization cache file " + tmp_path);
+		}
+
+		std::filesystem::rename(tmp_path, path);
+	}
+
+	std::lock_guard lock(entries_mutex);
+	entries.insert_or_assign(key, std::move(data));
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <initializer_list>
+#include <ranges>
+#include <span>
+#include <sstream>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+/*
+Cache of the precomputed coefficients and LAPACK factorizations, so repeated initializations of the same system become
+lookups. The entries are shared by all solvers of the process; the "factorization_cache" param (false by default)
+enables it. With the "factorization_cache_dir" param, the entries are also stored as files in the directory, so later
+runs can reuse them.
+
+The entries are kept in memory until the process ends and their total size is not limited. An entry has the size of
+the precomputed values of the solver (e.g. about 2 * n * substrates_count reals per dimension for least_compute, the
+banded factorization of each substrate for full_lapack), so with the cache enabled, the process holds these values
+twice. The lookups copy the data outside the lock, so the solvers initializing in parallel do not wait for each
+other's copies or file I/O.
+
+The key is built from everything the factorization depends on (see make_key). The real values are written as hexfloats,
+so only bitwise equal coefficients hit the cache.
+*/
+class factorization_cache
+{
+	bool enabled_ = false;
+	std::string directory_;
+
+	std::string get_file_path(const std::string& key) const;
+
+	template <typename value_t>
+	static void append_key(std::ostringstream& os, const value_t& value)
+	{
+		if constexpr (std::ranges::range<value_t> && !std::is_convertible_v<value_t, std::string>)
+		{
+			for (const auto& element : value)
+				os << element << ',';
+		}
+		else
+			os << value;
+
+		os << ';';
+	}
+
+public:
+	void tune(const nlohmann::json& params);
+
+	// Fills the buffers with the entry of the key, returns false if the cache is disabled or the entry is missing
+	bool load(const std::string& key, std::initializer_list<std::span<std::byte>> buffers) const;
+
+	// Stores the buffers as the entry of the key, does nothing if the cache is disabled
+	void store(const std::string& key, std::initializer_list<std::span<const std::byte>> buffers) const;
+
+	template <typename... values_t>
+	static std::string make_key(const values_t&... values)
+	{
+		std::ostringstream os;
+		os << std::hexfloat;
+
+		(append_key(os, values), ...);
+
+		return os.str();
+	}
+};
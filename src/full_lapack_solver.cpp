@@ -1,5 +1,6 @@
 #include "full_lapack_solver.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 
@@ -51,15 +52,60 @@ void full_lapack_solver<real_t>::precompute_values()
 
 	int kd = 1 * (problem_.dims >= 2 ? problem_.nx : 1) * (problem_.dims >= 3 ? problem_.ny : 1);
 
+	const std::size_t ab_size = (std::size_t)problem_.nx * problem_.ny * problem_.nz * (kd + 1);
+
 	auto ab_layout =
 		noarr::scalar<real_t>() ^ noarr::vectors<'i', 'j'>(kd + 1, problem_.nx * problem_.ny * problem_.nz);
 
-	for (index_t s_idx = 0; s_idx < problem_.substrates_count; s_idx++)
+	// substrates with the same coefficients share the band matrix
+	std::vector<index_t> band_substrates;
+	std::vector<index_t> substrate_bands(problem_.substrates_count);
+
+	for (index_t s = 0; s < problem_.substrates_count; s++)
+	{
+		auto same_coefficients = [&](index_t other) {
+			return problem_.diffusion_coefficients[s] == problem_.diffusion_coefficients[other]
+				   && problem_.decay_rates[s] == problem_.decay_rates[other];
+		};
+
+		auto it = std::find_if(band_substrates.begin(), band_substrates.end(), same_coefficients);
+		substrate_bands[s] = it - band_substrates.begin();
+
+		if (it == band_substrates.end())
+			band_substrates.push_back(s);
+	}
+
+	// up to work_items consecutive substrates with the same band are solved at once as multiple right hand sides
+	batches_.clear();
+	for (index_t s = 0; s < problem_.substrates_count; s++)
 	{
-		auto single_substr_ab = std::make_unique<real_t[]>(problem_.nx * problem_.ny * problem_.nz * (kd + 1));
+		if (!batches_.empty() && batches_.back().band == substrate_bands[s]
+			&& batches_.back().count < (index_t)work_items_)
+			batches_.back().count++;
+		else
+			batches_.push_back({ s, 1, substrate_bands[s] });
+	}
 
-		std::fill(single_substr_ab.get(), single_substr_ab.get() + problem_.nx * problem_.ny * problem_.nz * (kd + 1),
-				  0);
+	ab_.clear();
+	ab_.resize(band_substrates.size());
+
+	std::vector<int> infos(band_substrates.size());
+
+#pragma omp parallel for schedule(dynamic)
+	for (std::size_t band = 0; band < band_substrates.size(); band++)
+	{
+		const index_t s_idx = band_substrates[band];
+
+		auto& single_substr_ab = ab_[band] = allocator_.allocate<real_t>(ab_size);
+
+		const std::string key = factorization_cache::make_key(
+			"pbtrf", sizeof(real_t), problem_.dims, problem_.nx, problem_.ny, problem_.nz, problem_.dx, problem_.dy,
+			problem_.dz, problem_.dt, problem_.diffusion_coefficients[s_idx], problem_.decay_rates[s_idx]);
+
+		if (cache_.load(key, { std::as_writable_bytes(std::span(single_substr_ab.get(), ab_size)) }))
+			continue;
+
+		std::fill(single_substr_ab.get(), single_substr_ab.get() + ab_size, 0);
 
 		for (index_t z = 0; z < problem_.nz; z++)
 			for (index_t y = 0; y < problem_.ny; y++)
@@ -118,16 +164,17 @@ void full_lapack_solver<real_t>::precompute_values()
 								 + z_neighbors / (problem_.dz * problem_.dz));
 				}
 
-		int info;
 		int n = problem_.nx * problem_.ny * problem_.nz;
 		int ldab = kd + 1;
-		pbtrf("L", &n, &kd, single_substr_ab.get(), &ldab, &info);
-
-		if (info != 0)
-			throw std::runtime_error("LAPACK spttrf failed with error code " + std::to_string(info));
+		pbtrf("L", &n, &kd, single_substr_ab.get(), &ldab, &infos[band]);
 
-		ab_.emplace_back(std::move(single_substr_ab));
+		if (infos[band] == 0)
+			cache_.store(key, { std::as_bytes(std::span(single_substr_ab.get(), ab_size)) });
 	}
+
+	for (int info : infos)
+		if (info != 0)
+			throw std::runtime_error("LAPACK spbtrf failed with error code " + std::to_string(info));
 }
 
 template <typename real_t>
@@ -141,7 +188,7 @@ template <typename real_t>
 void full_lapack_solver<real_t>::prepare(const max_problem_t& problem)
 {
 	problem_ = problems::cast<std::int32_t, real_t>(problem);
-	substrates_ = std::make_unique<real_t[]>(problem_.nx * problem_.ny * problem_.nz * problem_.substrates_count);
+	substrates_ = allocator_.allocate<real_t>(problem_.nx * problem_.ny * problem_.nz * problem_.substrates_count);
 
 	// Initialize substrates
 
@@ -159,25 +206,39 @@ void full_lapack_solver<real_t>::initialize()
 template <typename real_t>
 void full_lapack_solver<real_t>::tune(const nlohmann::json& params)
 {
+	allocator_.tune(params);
+	cache_.tune(params);
+
 	work_items_ = params.contains("work_items") ? (std::size_t)params["work_items"] : 1;
 }
 
 template <typename real_t>
 void full_lapack_solver<real_t>::solve_x()
 {
-#pragma omp for schedule(static, 1) nowait
-	for (index_t s = 0; s < problem_.substrates_count; s++)
+	const int n = problem_.nx * problem_.ny * problem_.nz;
+	const int kd = 1 * (problem_.dims >= 2 ? problem_.nx : 1) * (problem_.dims >= 3 ? problem_.ny : 1);
+	const int ldab = kd + 1;
+
+	auto dens_l = get_substrates_layout(problem_);
+
+	bool failed = false;
+
+#pragma omp parallel for schedule(dynamic) reduction(|| : failed)
+	for (std::size_t i = 0; i < batches_.size(); i++)
 	{
+		const auto& batch = batches_[i];
+
+		// the substrates of the batch are consecutive, so their slices form a column-major matrix
+		real_t* b = &(dens_l | noarr::get_at<'x', 'y', 'z', 's'>(substrates_.get(), 0, 0, 0, batch.begin));
+
 		int info;
-		int n = problem_.nx * problem_.ny * problem_.nz;
-		int kd = 1 * (problem_.dims >= 2 ? problem_.nx : 1) * (problem_.dims >= 3 ? problem_.ny : 1);
-		int rhs = 1;
-		int ldab = kd + 1;
-		pbtrs("L", &n, &kd, &rhs, ab_[s].get(), &ldab, substrates_.get(), &n, &info);
+		pbtrs("L", &n, &kd, &batch.count, ab_[batch.band].get(), &ldab, b, &n, &info);
 
-		if (info != 0)
-			throw std::runtime_error("LAPACK spttrs failed with error code " + std::to_string(info));
+		failed = failed || info != 0;
 	}
+
+	if (failed)
+		throw std::runtime_error("LAPACK spbtrs failed");
 }
 
 template <typename real_t>
@@ -207,6 +268,13 @@ void full_lapack_solver<real_t>::save(const std::string& file) const
 	out.close();
 }
 
+template <typename real_t>
+std::span<const std::byte> full_lapack_solver<real_t>::substrates_memory() const
+{
+	return std::as_bytes(
+		std::span(substrates_.get(), problem_.nx * problem_.ny * problem_.nz * problem_.substrates_count));
+}
+
 template <typename real_t>
 double full_lapack_solver<real_t>::access(std::size_t s, std::size_t x, std::size_t y, std::size_t z) const
 {
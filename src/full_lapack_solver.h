@@ -2,6 +2,8 @@
 
 #include <memory>
 
+#include "aligned_allocator.h"
+#include "factorization_cache.h"
 #include "tridiagonal_solver.h"
 
 template <typename real_t>
@@ -11,9 +13,23 @@ class full_lapack_solver : public tridiagonal_solver
 
 	problem_t<index_t, real_t> problem_;
 
-	std::unique_ptr<real_t[]> substrates_;
+	aligned_allocator allocator_;
+	factorization_cache cache_;
 
-	std::vector<std::unique_ptr<real_t[]>> ab_;
+	aligned_buffer<real_t> substrates_;
+
+	// factorized band matrices of the distinct (diffusion coefficient, decay rate) pairs
+	std::vector<aligned_buffer<real_t>> ab_;
+
+	// consecutive substrates sharing a band matrix, solved as multiple right hand sides
+	struct batch_t
+	{
+		index_t begin;
+		index_t count;
+		index_t band;
+	};
+
+	std::vector<batch_t> batches_;
 
 	std::size_t work_items_;
 
@@ -39,5 +55,7 @@ public:
 
 	void save(const std::string& file) const override;
 
+	std::span<const std::byte> substrates_memory() const override;
+
 	double access(std::size_t s, std::size_t x, std::size_t y, std::size_t z) const override;
 };
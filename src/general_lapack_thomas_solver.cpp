@@ -1,5 +1,6 @@
 #include "general_lapack_thomas_solver.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 
@@ -54,13 +55,31 @@ void general_lapack_thomas_solver<real_t>::precompute_values(std::vector<std::un
 															 std::vector<std::unique_ptr<int[]>>& ipivs, index_t shape,
 															 index_t dims, index_t n)
 {
+	dls.clear();
+	ds.clear();
+	dus.clear();
+	du2s.clear();
+	ipivs.clear();
+
 	for (index_t s_idx = 0; s_idx < problem_.substrates_count; s_idx++)
 	{
-		auto dl = std::make_unique<real_t[]>(n - 1);
-		auto d = std::make_unique<real_t[]>(n);
-		auto du = std::make_unique<real_t[]>(n - 1);
-		auto du2 = std::make_unique<real_t[]>(n - 2);
-		auto ipiv = std::make_unique<int[]>(n);
+		auto& dl = dls.emplace_back(std::make_unique<real_t[]>(n - 1));
+		auto& d = ds.emplace_back(std::make_unique<real_t[]>(n));
+		auto& du = dus.emplace_back(std::make_unique<real_t[]>(n - 1));
+		auto& du2 = du2s.emplace_back(std::make_unique<real_t[]>(n - 2));
+		auto& ipiv = ipivs.emplace_back(std::make_unique<int[]>(n));
+
+		const std::string key =
+			factorization_cache::make_key("gttrf", sizeof(real_t), shape, dims, n, problem_.dt,
+										  problem_.diffusion_coefficients[s_idx], problem_.decay_rates[s_idx]);
+
+		if (cache_.load(key, { std::as_writable_bytes(std::span(dl.get(), n - 1)),
+							   std::as_writable_bytes(std::span(d.get(), n)),
+							   std::as_writable_bytes(std::span(du.get(), n - 1)),
+							   std::as_writable_bytes(std::span(du2.get(), n - 2)),
+							   std::as_writable_bytes(std::span(ipiv.get(), n)) }))
+			continue;
+
 		for (index_t i = 0; i < n; i++)
 		{
 			if (i != n - 1)
@@ -82,11 +101,9 @@ void general_lapack_thomas_solver<real_t>::precompute_values(std::vector<std::un
 		if (info != 0)
 			throw std::runtime_error("LAPACK spttrf failed with error code " + std::to_string(info));
 
-		dls.emplace_back(std::move(dl));
-		ds.emplace_back(std::move(d));
-		dus.emplace_back(std::move(du));
-		du2s.emplace_back(std::move(du2));
-		ipivs.emplace_back(std::move(ipiv));
+		cache_.store(key, { std::as_bytes(std::span(dl.get(), n - 1)), std::as_bytes(std::span(d.get(), n)),
+							std::as_bytes(std::span(du.get(), n - 1)), std::as_bytes(std::span(du2.get(), n - 2)),
+							std::as_bytes(std::span(ipiv.get(), n)) });
 	}
 }
 
@@ -101,7 +118,7 @@ template <typename real_t>
 void general_lapack_thomas_solver<real_t>::prepare(const max_problem_t& problem)
 {
 	problem_ = problems::cast<std::int32_t, real_t>(problem);
-	substrates_ = std::make_unique<real_t[]>(problem_.nx * problem_.ny * problem_.nz * problem_.substrates_count);
+	substrates_ = allocator_.allocate<real_t>(problem_.nx * problem_.ny * problem_.nz * problem_.substrates_count);
 
 	// Initialize substrates
 
@@ -124,14 +141,22 @@ void general_lapack_thomas_solver<real_t>::initialize()
 template <typename real_t>
 void general_lapack_thomas_solver<real_t>::tune(const nlohmann::json& params)
 {
+	allocator_.tune(params);
+	cache_.tune(params);
+
 	work_items_ = params.contains("work_items") ? (std::size_t)params["work_items"] : 1;
 }
 
 template <typename real_t>
 void general_lapack_thomas_solver<real_t>::solve_x()
 {
-	auto dens_l = get_substrates_layout(problem_) ^ noarr::merge_blocks<'y', 'z', 'm'>();
+	// consecutive x lines are (y, z) neighbours in the y dimension, so a batch of them forms a column-major matrix
+	auto dens_l = get_substrates_layout(problem_) ^ noarr::merge_blocks<'z', 'y', 'm'>();
 
+	// an exception can not leave the parallel region, so the first failure is recorded and thrown after it
+	int failed_info = 0;
+
+#pragma omp parallel
 	for (index_t s = 0; s < problem_.substrates_count; s++)
 	{
 #pragma omp for schedule(static, 1) nowait
@@ -147,18 +172,58 @@ void general_lapack_thomas_solver<real_t>::solve_x()
 				  substrates_.get() + begin_offset, &problem_.nx, &info);
 
 			if (info != 0)
-				throw std::runtime_error("LAPACK spttrs failed with error code " + std::to_string(info));
+			{
+#pragma omp critical
+				if (failed_info == 0)
+					failed_info = info;
+			}
 		}
 	}
+
+	if (failed_info != 0)
+		throw std::runtime_error("LAPACK gttrs failed with error code " + std::to_string(failed_info));
+}
+
+template <typename real_t>
+template <typename density_layout_t>
+void general_lapack_thomas_solver<real_t>::solve_strided_lines(
+	const density_layout_t dens_l, const std::vector<std::unique_ptr<real_t[]>>& dls,
+	const std::vector<std::unique_ptr<real_t[]>>& ds, const std::vector<std::unique_ptr<real_t[]>>& dus,
+	const std::vector<std::unique_ptr<real_t[]>>& du2s, const std::vector<std::unique_ptr<int[]>>& ipivs)
+{
+	const int failed_info = solver_utils::solve_strided_lines(
+		dens_l, substrates_.get(), allocator_, (int)work_items_, [&](int s, real_t* rhs_matrix, int n, int rhs) {
+			int info;
+			char c = 'N';
+			gttrs(&c, &n, &rhs, dls[s].get(), ds[s].get(), dus[s].get(), du2s[s].get(), ipivs[s].get(), rhs_matrix,
+				  &n, &info);
+			return info;
+		});
+
+	if (failed_info != 0)
+		throw std::runtime_error("LAPACK gttrs failed with error code " + std::to_string(failed_info));
 }
 
 template <typename real_t>
 void general_lapack_thomas_solver<real_t>::solve_y()
-{}
+{
+	if (problem_.dims < 2)
+		return;
+
+	solve_strided_lines(get_substrates_layout(problem_) ^ noarr::rename<'y', 'i', 'x', 'q', 'z', 'm'>(), dly_, dy_,
+						duy_, du2y_, ipivy_);
+}
 
 template <typename real_t>
 void general_lapack_thomas_solver<real_t>::solve_z()
-{}
+{
+	if (problem_.dims < 3)
+		return;
+
+	solve_strided_lines(get_substrates_layout(problem_) ^ noarr::rename<'z', 'i'>()
+							^ noarr::merge_blocks<'y', 'x', 'q'>() ^ noarr::vector<'m'>(1),
+						dlz_, dz_, duz_, du2z_, ipivz_);
+}
 
 template <typename real_t>
 void general_lapack_thomas_solver<real_t>::save(const std::string& file) const
@@ -179,6 +244,13 @@ void general_lapack_thomas_solver<real_t>::save(const std::string& file) const
 	out.close();
 }
 
+template <typename real_t>
+std::span<const std::byte> general_lapack_thomas_solver<real_t>::substrates_memory() const
+{
+	return std::as_bytes(
+		std::span(substrates_.get(), problem_.nx * problem_.ny * problem_.nz * problem_.substrates_count));
+}
+
 template <typename real_t>
 double general_lapack_thomas_solver<real_t>::access(std::size_t s, std::size_t x, std::size_t y, std::size_t z) const
 {
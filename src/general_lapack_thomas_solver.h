@@ -2,6 +2,8 @@
 
 #include <memory>
 
+#include "aligned_allocator.h"
+#include "factorization_cache.h"
 #include "tridiagonal_solver.h"
 
 template <typename real_t>
@@ -11,7 +13,10 @@ class general_lapack_thomas_solver : public tridiagonal_solver
 
 	problem_t<index_t, real_t> problem_;
 
-	std::unique_ptr<real_t[]> substrates_;
+	aligned_allocator allocator_;
+	factorization_cache cache_;
+
+	aligned_buffer<real_t> substrates_;
 
 	std::vector<std::unique_ptr<real_t[]>> dlx_, dx_, dux_, du2x_;
 	std::vector<std::unique_ptr<real_t[]>> dly_, dy_, duy_, du2y_;
@@ -27,6 +32,13 @@ class general_lapack_thomas_solver : public tridiagonal_solver
 						   std::vector<std::unique_ptr<real_t[]>>& dus, std::vector<std::unique_ptr<real_t[]>>& du2s,
 						   std::vector<std::unique_ptr<int[]>>& ipivs, index_t shape, index_t dims, index_t n);
 
+	template <typename density_layout_t>
+	void solve_strided_lines(const density_layout_t dens_l, const std::vector<std::unique_ptr<real_t[]>>& dls,
+							 const std::vector<std::unique_ptr<real_t[]>>& ds,
+							 const std::vector<std::unique_ptr<real_t[]>>& dus,
+							 const std::vector<std::unique_ptr<real_t[]>>& du2s,
+							 const std::vector<std::unique_ptr<int[]>>& ipivs);
+
 	void gttrf(const int* n, real_t* dl, real_t* d, real_t* du, real_t* du2, int* ipiv, int* info);
 	void gttrs(const char* trans, const int* n, const int* nrhs, const real_t* dl, const real_t* d, const real_t* du,
 			   const real_t* du2, const int* ipiv, real_t* b, const int* ldb, int* info);
@@ -44,5 +56,7 @@ public:
 
 	void save(const std::string& file) const override;
 
+	std::span<const std::byte> substrates_memory() const override;
+
 	double access(std::size_t s, std::size_t x, std::size_t y, std::size_t z) const override;
 };
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+
+/*
+16-bit storage types of the densities. They only convert from and to float, so the kernels load them into float,
+compute in float and round the results back when storing.
+
+The conversions use the compiler's native types when it provides them (__bf16 since GCC 13 and Clang 17, _Float16).
+They compile to the AVX-512 BF16 and F16C/AVX-512 FP16 conversion instructions when the build targets them (e.g.
+-march=sapphirerapids), otherwise to the compiler's runtime rounding routines. Without the native types, the portable
+bit manipulation fallbacks round to the nearest even value as the instructions do.
+*/
+
+struct bf16_t
+{
+	std::uint16_t bits;
+
+	bf16_t() = default;
+
+	bf16_t(float value) : bits(from_float(value)) {}
+
+	operator float() const { return std::bit_cast<float>((std::uint32_t)bits << 16); }
+
+	static std::uint16_t from_float(float value)
+	{
+#if defined(__BFLT16_MANT_DIG__)
+		return std::bit_cast<std::uint16_t>(static_cast<__bf16>(value));
+#else
+		std::uint32_t u = std::bit_cast<std::uint32_t>(value);
+
+		// keep NaNs quiet, the rounding could turn them into infinities
+		if ((u & 0x7fffffff) > 0x7f800000)
+			return (u >> 16) | 0x40;
+
+		u += 0x7fff + ((u >> 16) & 1);
+
+		return u >> 16;
+#endif
+	}
+};
+
+struct fp16_t
+{
+	std::uint16_t bits;
+
+	fp16_t() = default;
+
+	fp16_t(float value) : bits(from_float(value)) {}
+
+	operator float() const { return to_float(bits); }
+
+	static std::uint16_t from_float(float value)
+	{
+#if defined(__FLT16_MANT_DIG__)
+		return std::bit_cast<std::uint16_t>(static_cast<_Float16>(value));
+#else
+		std::uint32_t u = std::bit_cast<std::uint32_t>(value);
+		const std::uint16_t sign = (u >> 16) & 0x8000;
+		u &= 0x7fffffff;
+
+		// infinity and NaN
+		if (u >= 0x7f800000)
+			return sign | 0x7c00 | (u > 0x7f800000 ? 0x200 : 0);
+
+		// rounds to infinity
+		if (u >= 0x477ff000)
+			return sign | 0x7c00;
+
+		// subnormal, the float addition does the rounding
+		if (u < 0x38800000)
+			return sign | (std::bit_cast<std::uint32_t>(std::bit_cast<float>(u) + 0.5f) - 0x3f000000);
+
+		// rebias the exponent and round the mantissa to the nearest even
+		u += ((15u - 127u) << 23) + 0xfff + ((u >> 13) & 1);
+
+		return sign | (u >> 13);
+#endif
+	}
+
+	static float to_float(std::uint16_t bits)
+	{
+#if defined(__FLT16_MANT_DIG__)
+		return static_cast<float>(std::bit_cast<_Float16>(bits));
+#else
+		const std::uint32_t sign = (std::uint32_t)(bits & 0x8000) << 16;
+		const std::uint32_t exponent = (bits >> 10) & 0x1f;
+		const std::uint32_t mantissa = bits & 0x3ff;
+
+		// zero and subnormal
+		if (exponent == 0)
+			return std::bit_cast<float>(sign | std::bit_cast<std::uint32_t>(mantissa * 0x1p-24f));
+
+		// infinity and NaN
+		if (exponent == 0x1f)
+			return std::bit_cast<float>(sign | 0x7f800000 | (mantissa << 13));
+
+		return std::bit_cast<float>(sign | ((exponent + 127 - 15) << 23) | (mantissa << 13));
+#endif
+	}
+};
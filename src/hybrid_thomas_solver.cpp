@@ -0,0 +1,205 @@
+#include "hybrid_thomas_solver.h"
+
+#include <stdexcept>
+
+#include "least_compute_thomas_kernels.h"
+#include "solver_utils.h"
+
+template <typename real_t, typename index_t>
+typename hybrid_thomas_solver<real_t, index_t>::kernel_t hybrid_thomas_solver<real_t, index_t>::read_kernel(
+	const nlohmann::json& params, const std::string& name)
+{
+	if (!params.contains(name))
+		return kernel_t::lstc;
+
+	const std::string kernel = params[name];
+
+	if (kernel == "lstc")
+		return kernel_t::lstc;
+	if (kernel == "partitioned")
+		return kernel_t::partitioned;
+
+	throw std::runtime_error("The " + name + " param must be \"lstc\" or \"partitioned\"");
+}
+
+template <typename real_t, typename index_t>
+void hybrid_thomas_solver<real_t, index_t>::tune(const nlohmann::json& params)
+{
+	base_t::tune(params);
+
+	kernel_x_ = read_kernel(params, "kernel_x");
+	kernel_y_ = read_kernel(params, "kernel_y");
+	kernel_z_ = read_kernel(params, "kernel_z");
+}
+
+template <typename real_t, typename index_t>
+void hybrid_thomas_solver<real_t, index_t>::precompute_dimension(kernel_t& kernel,
+																  partitioned_values_t<real_t, index_t>& partitioned,
+																  aligned_buffer<real_t>& a, aligned_buffer<real_t>& b0,
+																  aligned_buffer<real_t>& b, aligned_buffer<real_t>& c,
+																  aligned_buffer<real_t>& e, index_t shape, index_t n)
+{
+	// each chunk of a partitioned line needs at least 3 rows
+	if (n < 3)
+		kernel = kernel_t::lstc;
+
+	if (kernel == kernel_t::lstc)
+	{
+		this->precompute_values(b, c, e, shape, this->problem_.dims, n, 1);
+		return;
+	}
+
+	a = this->allocator_.template allocate<real_t>(this->problem_.substrates_count);
+	b0 = this->allocator_.template allocate<real_t>(this->problem_.substrates_count);
+
+	for (index_t s = 0; s < this->problem_.substrates_count; s++)
+	{
+		a[s] = -this->problem_.dt * this->problem_.diffusion_coefficients[s] / (shape * shape);
+		b0[s] = 1 + this->problem_.dt * this->problem_.decay_rates[s] / this->problem_.dims
+				+ this->problem_.dt * this->problem_.diffusion_coefficients[s] / (shape * shape);
+	}
+
+	precompute_partitioned_values(partitioned, this->allocator_, a.get(), b0.get(), n, this->problem_.substrates_count);
+}
+
+template <typename real_t, typename index_t>
+void hybrid_thomas_solver<real_t, index_t>::initialize()
+{
+	if (this->problem_.dims >= 1)
+		precompute_dimension(kernel_x_, partitionedx_, ax_, b0x_, this->bx_, this->cx_, this->ex_, this->problem_.dx,
+							 this->problem_.nx);
+	if (this->problem_.dims >= 2)
+		precompute_dimension(kernel_y_, partitionedy_, ay_, b0y_, this->by_, this->cy_, this->ey_, this->problem_.dy,
+							 this->problem_.ny);
+	if (this->problem_.dims >= 3)
+		precompute_dimension(kernel_z_, partitionedz_, az_, b0z_, this->bz_, this->cz_, this->ez_, this->problem_.dz,
+							 this->problem_.nz);
+}
+
+template <typename real_t, typename index_t>
+void hybrid_thomas_solver<real_t, index_t>::solve_x_omp()
+{
+	solver_utils::dispatch_substrates_count(
+		this->problem_.substrates_count, this->specialized_, [&](auto substrates_count) {
+			if (kernel_x_ == kernel_t::partitioned)
+			{
+				if (this->problem_.dims == 1)
+				{
+					solve_slice_partitioned<index_t>(
+						this->substrates_.get(), ax_.get(), partitionedx_,
+						this->template get_substrates_layout<1>(this->problem_, substrates_count)
+							^ noarr::rename<'x', 'i'>() ^ noarr::vector<'q'>(1) ^ noarr::vector<'m'>(1));
+				}
+				else if (this->problem_.dims == 2)
+				{
+					solve_slice_partitioned<index_t>(
+						this->substrates_.get(), ax_.get(), partitionedx_,
+						this->template get_substrates_layout<2>(this->problem_, substrates_count)
+							^ noarr::rename<'x', 'i', 'y', 'm'>() ^ noarr::vector<'q'>(1));
+				}
+				else if (this->problem_.dims == 3)
+				{
+					solve_slice_partitioned<index_t>(
+						this->substrates_.get(), ax_.get(), partitionedx_,
+						this->template get_substrates_layout<3>(this->problem_, substrates_count)
+							^ noarr::rename<'x', 'i'>() ^ noarr::merge_blocks<'z', 'y', 'm'>() ^ noarr::vector<'q'>(1));
+				}
+			}
+			else if (this->problem_.dims == 1)
+			{
+				solve_slice_x_1d<index_t>(this->substrates_.get(), this->bx_.get(), this->cx_.get(), this->ex_.get(),
+										  this->template get_substrates_layout<1>(this->problem_, substrates_count),
+										  this->work_items_);
+			}
+			else if (this->problem_.dims == 2)
+			{
+				auto dens_l = this->template get_substrates_layout<2>(this->problem_, substrates_count);
+
+				solve_slice_x_2d_and_3d<index_t>(this->substrates_.get(), this->bx_.get(), this->cx_.get(),
+												 this->ex_.get(), dens_l ^ noarr::rename<'y', 'm'>(),
+												 this->work_items_);
+			}
+			else if (this->problem_.dims == 3)
+			{
+				auto dens_l = this->template get_substrates_layout<3>(this->problem_, substrates_count);
+
+				solve_slice_x_2d_and_3d<index_t>(this->substrates_.get(), this->bx_.get(), this->cx_.get(),
+												 this->ex_.get(), dens_l ^ noarr::merge_blocks<'z', 'y', 'm'>(),
+												 this->work_items_);
+			}
+		});
+}
+
+template <typename real_t, typename index_t>
+void hybrid_thomas_solver<real_t, index_t>::solve_y_omp()
+{
+	solver_utils::dispatch_substrates_count(
+		this->problem_.substrates_count, this->specialized_, [&](auto substrates_count) {
+			if (kernel_y_ == kernel_t::partitioned)
+			{
+				if (this->problem_.dims == 2)
+				{
+					solve_slice_partitioned<index_t>(
+						this->substrates_.get(), ay_.get(), partitionedy_,
+						this->template get_substrates_layout<2>(this->problem_, substrates_count)
+							^ noarr::rename<'x', 'q', 'y', 'i'>() ^ noarr::vector<'m'>(1));
+				}
+				else if (this->problem_.dims == 3)
+				{
+					solve_slice_partitioned<index_t>(
+						this->substrates_.get(), ay_.get(), partitionedy_,
+						this->template get_substrates_layout<3>(this->problem_, substrates_count)
+							^ noarr::rename<'x', 'q', 'y', 'i', 'z', 'm'>());
+				}
+			}
+			else if (this->problem_.dims == 2)
+			{
+				solve_slice_y_2d<index_t>(this->substrates_.get(), this->by_.get(), this->cy_.get(), this->ey_.get(),
+										  this->template get_substrates_layout<2>(this->problem_, substrates_count),
+										  this->work_items_);
+			}
+			else if (this->problem_.dims == 3)
+			{
+				solve_slice_y_3d<index_t>(this->substrates_.get(), this->by_.get(), this->cy_.get(), this->ey_.get(),
+										  this->template get_substrates_layout<3>(this->problem_, substrates_count),
+										  this->work_items_);
+			}
+		});
+}
+
+template <typename real_t, typename index_t>
+void hybrid_thomas_solver<real_t, index_t>::solve_z_omp()
+{
+	if (this->problem_.dims != 3)
+		return;
+
+	solver_utils::dispatch_substrates_count(
+		this->problem_.substrates_count, this->specialized_, [&](auto substrates_count) {
+			auto dens_l = this->template get_substrates_layout<3>(this->problem_, substrates_count);
+
+			if (kernel_z_ == kernel_t::partitioned)
+			{
+				solve_slice_partitioned<index_t>(this->substrates_.get(), az_.get(), partitionedz_,
+												 dens_l ^ noarr::rename<'z', 'i'>()
+													 ^ noarr::merge_blocks<'y', 'x', 'q'>() ^ noarr::vector<'m'>(1));
+			}
+			else if (this->z_tile_size_ > 0)
+			{
+				solve_slice_z_3d_tiled<index_t>(this->substrates_.get(), this->bz_.get(), this->cz_.get(),
+												this->ez_.get(), dens_l ^ noarr::merge_blocks<'y', 'x', 'm'>(),
+												this->z_tile_size_);
+			}
+			else
+			{
+				solve_slice_z_3d<index_t>(this->substrates_.get(), this->bz_.get(), this->cz_.get(), this->ez_.get(),
+										  dens_l, this->work_items_);
+			}
+		});
+}
+
+// The kernels of different solvers distribute the densities differently and some of them end without a barrier, so
+// the sweeps are separated by barriers
+template class hybrid_thomas_solver<float, std::int32_t>;
+template class hybrid_thomas_solver<float, std::int64_t>;
+template class hybrid_thomas_solver<double, std::int32_t>;
+template class hybrid_thomas_solver<double, std::int64_t>;
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+
+#include "least_compute_thomas_solver.h"
+#include "partitioned_thomas_kernels.h"
+
+/*
+Composes the sweeps of different solvers on the shared least_compute layout (s, x, y, z from the innermost, padded as
+in least_compute_thomas_solver). The "kernel_x", "kernel_y" and "kernel_z" params select the kernel of each dimension:
+- "lstc" (default) - the least_compute slice kernels; the z sweep is tiled by "z_tile_size" as in least_compute,
+- "partitioned" - the partitioned (SPIKE-like) kernel of least_memory_thomas_solver, which splits each line into
+  chunks solved by different threads, so it keeps all threads busy on few long lines.
+The kernels take the densities buffer and its layout, so they all run on the same buffer without any copies. Each
+dimension precomputes only the values of its kernel. The partitioned kernel vectorizes over the neighbouring lines,
+which are contiguous in this layout only for a single substrate.
+
+So e.g. {"kernel_z": "partitioned"} keeps the lstc x and y sweeps and solves z by the partitioned kernel.
+*/
+
+template <typename real_t, typename index_t>
+class hybrid_thomas_solver : public least_compute_variant<real_t, index_t>
+{
+	using base_t = least_compute_variant<real_t, index_t>;
+
+	enum class kernel_t
+	{
+		lstc,
+		partitioned
+	};
+
+	kernel_t kernel_x_, kernel_y_, kernel_z_;
+
+	// the per-substrate off-diagonal and boundary diagonal values of the partitioned dimensions
+	aligned_buffer<real_t> ax_, b0x_, ay_, b0y_, az_, b0z_;
+
+	partitioned_values_t<real_t, index_t> partitionedx_, partitionedy_, partitionedz_;
+
+	static kernel_t read_kernel(const nlohmann::json& params, const std::string& name);
+
+	// Precomputes the values of the selected kernel; a line too short to be partitioned falls back to lstc
+	void precompute_dimension(kernel_t& kernel, partitioned_values_t<real_t, index_t>& partitioned,
+							  aligned_buffer<real_t>& a, aligned_buffer<real_t>& b0, aligned_buffer<real_t>& b,
+							  aligned_buffer<real_t>& c, aligned_buffer<real_t>& e, index_t shape, index_t n);
+
+	void solve_x_omp() override;
+	void solve_y_omp() override;
+	void solve_z_omp() override;
+
+public:
+	void tune(const nlohmann::json& params) override;
+
+	void initialize() override;
+};
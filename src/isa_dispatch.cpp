@@ -0,0 +1,72 @@
+#include "isa_dispatch.h"
+
+#include <stdexcept>
+
+isa_t isa_dispatch::selected_ = isa_dispatch::detect();
+
+isa_t isa_dispatch::detect()
+{
+#ifdef DIFFUSE_ISA_DISPATCH
+	// may run during the static initialization, before the CPU model is initialized by libgcc
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx512bw")
+		&& __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512cd") && __builtin_cpu_supports("avx2")
+		&& __builtin_cpu_supports("fma") && __builtin_cpu_supports("bmi2"))
+		return isa_t::avx512;
+
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("bmi2"))
+		return isa_t::avx2;
+
+	return isa_t::baseline;
+#else
+	return isa_t::native;
+#endif
+}
+
+void isa_dispatch::select(const nlohmann::json& params)
+{
+	const std::string isa = params.contains("isa") ? (std::string)params["isa"] : "auto";
+
+	const isa_t detected = detect();
+
+	if (isa == "auto" || isa == name(detected))
+	{
+		selected_ = detected;
+		return;
+	}
+
+#ifdef DIFFUSE_ISA_DISPATCH
+	for (isa_t candidate : { isa_t::baseline, isa_t::avx2, isa_t::avx512 })
+	{
+		if (isa != name(candidate))
+			continue;
+
+		if (candidate > detected)
+			throw std::runtime_error("The CPU does not support the instruction set " + isa);
+
+		selected_ = candidate;
+		return;
+	}
+
+	throw std::runtime_error("Unknown instruction set: " + isa);
+#else
+	throw std::runtime_error("The instruction set " + isa
+							 + " cannot be selected, the build is not configured with DIFFUSE_ISA_DISPATCH");
+#endif
+}
+
+std::string isa_dispatch::name(isa_t isa)
+{
+	switch (isa)
+	{
+		case isa_t::baseline:
+			return "x86-64-v2";
+		case isa_t::avx2:
+			return "avx2";
+		case isa_t::avx512:
+			return "avx512";
+		default:
+			return "native";
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+/*
+Runtime selection of the instruction set the hot kernels run with.
+
+By default, everything is compiled with -march=native and run() just calls the function. With the DIFFUSE_ISA_DISPATCH
+CMake option, the binary targets the x86-64-v2 baseline, so it runs on any node of a fleet, and run() calls the function
+in a clone compiled for the selected instruction set. The clones are flattened, so the kernels called by the function
+are inlined into them and vectorized for the instruction set of the clone.
+
+OpenMP parallel regions (and tasks) are outlined before the inlining, so run() has to be called inside the parallel
+region and the function may only contain orphaned worksharing constructs.
+
+Only the compiler's auto-vectorization benefits from the clones. Code selecting intrinsics by the preprocessor (e.g.
+__AVX2__ in transpose_simd.h) sees the x86-64-v2 baseline, so the explicit SIMD kernels are not available in these
+builds and least_memory rejects "vectorized_x".
+*/
+
+#if defined(DIFFUSE_ISA_DISPATCH) && !(defined(__GNUC__) && defined(__x86_64__))
+	#error "DIFFUSE_ISA_DISPATCH requires GCC or Clang targeting x86-64"
+#endif
+
+enum class isa_t
+{
+	native,
+	baseline,
+	avx2,
+	avx512
+};
+
+class isa_dispatch
+{
+	static isa_t selected_;
+
+#ifdef DIFFUSE_ISA_DISPATCH
+	template <typename func_t>
+	[[gnu::target("avx2,fma,bmi,bmi2,lzcnt,movbe,f16c"), gnu::flatten]] static void run_avx2(func_t& func)
+	{
+		func();
+	}
+
+	template <typename func_t>
+	[[gnu::target("avx512f,avx512vl,avx512bw,avx512dq,avx512cd,avx2,fma,bmi,bmi2,lzcnt,movbe,f16c,"
+				  "prefer-vector-width=512"),
+	  gnu::flatten]] static void run_avx512(func_t& func)
+	{
+		func();
+	}
+#endif
+
+public:
+	// The best instruction set supported by both the build and the CPU
+	static isa_t detect();
+
+	// Selects the instruction set according to the "isa" parameter:
+	// - "auto" (default) selects the detected one,
+	// - "x86-64-v2", "avx2" or "avx512" forces the instruction set, which has to be supported by the CPU.
+	// Builds without DIFFUSE_ISA_DISPATCH accept only "auto" and "native".
+	static void select(const nlohmann::json& params);
+
+	static isa_t selected() { return selected_; }
+
+	static std::string name(isa_t isa);
+
+	// Calls func in the clone of the selected instruction set
+	template <typename func_t>
+	static void run(func_t&& func)
+	{
+#ifdef DIFFUSE_ISA_DISPATCH
+		switch (selected_)
+		{
+			case isa_t::avx512:
+				run_avx512(func);
+				return;
+			case isa_t::avx2:
+				run_avx2(func);
+				return;
+			default:
+				break;
+		}
+#endif
+		func();
+	}
+};
@@ -1,5 +1,6 @@
 #include "lapack_thomas_solver.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 
@@ -64,10 +65,22 @@ void lapack_thomas_solver<real_t>::precompute_values(std::vector<std::unique_ptr
 													 std::vector<std::unique_ptr<real_t[]>>& b, index_t shape,
 													 index_t dims, index_t n)
 {
+	a.clear();
+	b.clear();
+
 	for (index_t s_idx = 0; s_idx < problem_.substrates_count; s_idx++)
 	{
-		auto single_substr_a = std::make_unique<real_t[]>(n - 1);
-		auto single_substr_b = std::make_unique<real_t[]>(n);
+		auto& single_substr_a = a.emplace_back(std::make_unique<real_t[]>(n - 1));
+		auto& single_substr_b = b.emplace_back(std::make_unique<real_t[]>(n));
+
+		const std::string key =
+			factorization_cache::make_key("pttrf", sizeof(real_t), shape, dims, n, problem_.dt,
+										  problem_.diffusion_coefficients[s_idx], problem_.decay_rates[s_idx]);
+
+		if (cache_.load(key, { std::as_writable_bytes(std::span(single_substr_a.get(), n - 1)),
+							   std::as_writable_bytes(std::span(single_substr_b.get(), n)) }))
+			continue;
+
 		for (index_t i = 0; i < n; i++)
 		{
 			if (i != n - 1)
@@ -86,8 +99,8 @@ void lapack_thomas_solver<real_t>::precompute_values(std::vector<std::unique_ptr
 		if (info != 0)
 			throw std::runtime_error("LAPACK spttrf failed with error code " + std::to_string(info));
 
-		a.emplace_back(std::move(single_substr_a));
-		b.emplace_back(std::move(single_substr_b));
+		cache_.store(key, { std::as_bytes(std::span(single_substr_a.get(), n - 1)),
+							std::as_bytes(std::span(single_substr_b.get(), n)) });
 	}
 }
 
@@ -102,7 +115,7 @@ template <typename real_t>
 void lapack_thomas_solver<real_t>::prepare(const max_problem_t& problem)
 {
 	problem_ = problems::cast<std::int32_t, real_t>(problem);
-	substrates_ = std::make_unique<real_t[]>(problem_.nx * problem_.ny * problem_.nz * problem_.substrates_count);
+	substrates_ = allocator_.allocate<real_t>(problem_.nx * problem_.ny * problem_.nz * problem_.substrates_count);
 
 	// Initialize substrates
 
@@ -125,14 +138,22 @@ void lapack_thomas_solver<real_t>::initialize()
 template <typename real_t>
 void lapack_thomas_solver<real_t>::tune(const nlohmann::json& params)
 {
+	allocator_.tune(params);
+	cache_.tune(params);
+
 	work_items_ = params.contains("work_items") ? (std::size_t)params["work_items"] : 1;
 }
 
 template <typename real_t>
 void lapack_thomas_solver<real_t>::solve_x()
 {
-	auto dens_l = get_substrates_layout(problem_) ^ noarr::merge_blocks<'y', 'z', 'm'>();
+	// consecutive x lines are (y, z) neighbours in the y dimension, so a batch of them forms a column-major matrix
+	auto dens_l = get_substrates_layout(problem_) ^ noarr::merge_blocks<'z', 'y', 'm'>();
+
+	// an exception can not leave the parallel region, so the first failure is recorded and thrown after it
+	int failed_info = 0;
 
+#pragma omp parallel
 	for (index_t s = 0; s < problem_.substrates_count; s++)
 	{
 #pragma omp for schedule(static, 1) nowait
@@ -146,18 +167,54 @@ void lapack_thomas_solver<real_t>::solve_x()
 				  &info);
 
 			if (info != 0)
-				throw std::runtime_error("LAPACK spttrs failed with error code " + std::to_string(info));
+			{
+#pragma omp critical
+				if (failed_info == 0)
+					failed_info = info;
+			}
 		}
 	}
+
+	if (failed_info != 0)
+		throw std::runtime_error("LAPACK pttrs failed with error code " + std::to_string(failed_info));
+}
+
+template <typename real_t>
+template <typename density_layout_t>
+void lapack_thomas_solver<real_t>::solve_strided_lines(const density_layout_t dens_l,
+													   const std::vector<std::unique_ptr<real_t[]>>& a,
+													   const std::vector<std::unique_ptr<real_t[]>>& b)
+{
+	const int failed_info = solver_utils::solve_strided_lines(
+		dens_l, substrates_.get(), allocator_, (int)work_items_, [&](int s, real_t* rhs_matrix, int n, int rhs) {
+			int info;
+			pttrs(&n, &rhs, b[s].get(), a[s].get(), rhs_matrix, &n, &info);
+			return info;
+		});
+
+	if (failed_info != 0)
+		throw std::runtime_error("LAPACK pttrs failed with error code " + std::to_string(failed_info));
 }
 
 template <typename real_t>
 void lapack_thomas_solver<real_t>::solve_y()
-{}
+{
+	if (problem_.dims < 2)
+		return;
+
+	solve_strided_lines(get_substrates_layout(problem_) ^ noarr::rename<'y', 'i', 'x', 'q', 'z', 'm'>(), ay_, by_);
+}
 
 template <typename real_t>
 void lapack_thomas_solver<real_t>::solve_z()
-{}
+{
+	if (problem_.dims < 3)
+		return;
+
+	solve_strided_lines(get_substrates_layout(problem_) ^ noarr::rename<'z', 'i'>()
+							^ noarr::merge_blocks<'y', 'x', 'q'>() ^ noarr::vector<'m'>(1),
+						az_, bz_);
+}
 
 template <typename real_t>
 void lapack_thomas_solver<real_t>::save(const std::string& file) const
@@ -178,6 +235,13 @@ void lapack_thomas_solver<real_t>::save(const std::string& file) const
 	out.close();
 }
 
+template <typename real_t>
+std::span<const std::byte> lapack_thomas_solver<real_t>::substrates_memory() const
+{
+	return std::as_bytes(
+		std::span(substrates_.get(), problem_.nx * problem_.ny * problem_.nz * problem_.substrates_count));
+}
+
 template <typename real_t>
 double lapack_thomas_solver<real_t>::access(std::size_t s, std::size_t x, std::size_t y, std::size_t z) const
 {
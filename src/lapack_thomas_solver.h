@@ -2,6 +2,8 @@
 
 #include <memory>
 
+#include "aligned_allocator.h"
+#include "factorization_cache.h"
 #include "tridiagonal_solver.h"
 
 template <typename real_t>
@@ -11,7 +13,10 @@ class lapack_thomas_solver : public tridiagonal_solver
 
 	problem_t<index_t, real_t> problem_;
 
-	std::unique_ptr<real_t[]> substrates_;
+	aligned_allocator allocator_;
+	factorization_cache cache_;
+
+	aligned_buffer<real_t> substrates_;
 
 	std::vector<std::unique_ptr<real_t[]>> ax_, bx_;
 	std::vector<std::unique_ptr<real_t[]>> ay_, by_;
@@ -24,6 +29,10 @@ class lapack_thomas_solver : public tridiagonal_solver
 	void precompute_values(std::vector<std::unique_ptr<real_t[]>>& a, std::vector<std::unique_ptr<real_t[]>>& b,
 						   index_t shape, index_t dims, index_t n);
 
+	template <typename density_layout_t>
+	void solve_strided_lines(const density_layout_t dens_l, const std::vector<std::unique_ptr<real_t[]>>& a,
+							 const std::vector<std::unique_ptr<real_t[]>>& b);
+
 	static void pttrf(const int* n, real_t* d, real_t* e, int* info);
 	static void pttrs(const int* n, const int* nrhs, const real_t* d, const real_t* e, real_t* b, const int* ldb,
 					  int* info);
@@ -42,5 +51,7 @@ public:
 
 	void save(const std::string& file) const override;
 
+	std::span<const std::byte> substrates_memory() const override;
+
 	double access(std::size_t s, std::size_t x, std::size_t y, std::size_t z) const override;
 };
@@ -0,0 +1,37 @@
+#include "layout_padding.h"
+
+#include <stdexcept>
+#include <string>
+
+layout_padding::dimension_t layout_padding::read_param(const nlohmann::json& params, const std::string& name)
+{
+	if (!params.contains(name))
+		return {};
+
+	if (params[name].is_string())
+	{
+		if ((std::string)params[name] != "auto")
+			throw std::runtime_error("The " + name + " param must be a number or \"auto\"");
+
+		return { true, 0 };
+	}
+
+	return { false, (std::size_t)params[name] };
+}
+
+std::size_t layout_padding::resolve(const dimension_t& dimension, std::size_t length, std::size_t element_bytes)
+{
+	if (!dimension.automatic)
+		return dimension.elements;
+
+	if (length * element_bytes % critical_stride_ != 0)
+		return 0;
+
+	return (cache_line_size_ + element_bytes - 1) / element_bytes;
+}
+
+void layout_padding::tune(const nlohmann::json& params)
+{
+	x_ = read_param(params, "pad_x");
+	y_ = read_param(params, "pad_y");
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#include <nlohmann/json.hpp>
+
+/*
+Padding of the leading dimensions of the substrate layouts. With power-of-two extents, the consecutive lines (or planes)
+visited by a sweep start at the same offset within a 4 KiB page, so their loads and stores alias in the store buffer
+(4K aliasing) and compete for the same cache sets. A few unused elements appended to each x line and to each xy plane
+shift the lines and planes apart.
+
+The "pad_x" param is the number of the x points appended to each x line and the "pad_y" param is the number of the x
+lines appended to each xy plane. Either is a number (0 by default) or "auto", which pads by a cache line only the lines
+or planes whose size is a multiple of 4 KiB.
+*/
+class layout_padding
+{
+	struct dimension_t
+	{
+		bool automatic = false;
+		std::size_t elements = 0;
+	};
+
+	dimension_t x_, y_;
+
+	static constexpr std::size_t critical_stride_ = 4096;
+	static constexpr std::size_t cache_line_size_ = 64;
+
+	static dimension_t read_param(const nlohmann::json& params, const std::string& name);
+
+	static std::size_t resolve(const dimension_t& dimension, std::size_t length, std::size_t element_bytes);
+
+public:
+	void tune(const nlohmann::json& params);
+
+	// The padding of an x line of nx points, each point_bytes large
+	std::size_t get_x(std::size_t nx, std::size_t point_bytes) const { return resolve(x_, nx, point_bytes); }
+
+	// The padding of an xy plane of ny lines, each line_bytes large
+	std::size_t get_y(std::size_t ny, std::size_t line_bytes) const { return resolve(y_, ny, line_bytes); }
+
+	// The padding of the x lines and of the xy planes of a grid of the given dimensionality; a 1D line and a 2D plane
+	// are not padded
+	std::pair<std::size_t, std::size_t> get(std::size_t dims, std::size_t nx, std::size_t ny,
+											std::size_t point_bytes) const
+	{
+		const std::size_t pad_x = dims >= 2 ? get_x(nx, point_bytes) : 0;
+		const std::size_t pad_y = dims >= 3 ? get_y(ny, (nx + pad_x) * point_bytes) : 0;
+
+		return { pad_x, pad_y };
+	}
+};
@@ -0,0 +1,373 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+#include <noarr/structures_extended.hpp>
+
+// Line and slab kernels of the least_compute solver shared by its variants; the b, c, e values are precomputed by
+// least_compute_thomas_solver::precompute_values
+
+// Solves the x line yz; the density layout has dimensions 'm' (merged y and z), 'x' and 's'
+template <typename index_t, typename real_t, typename density_layout_t>
+inline void solve_line_x(real_t* __restrict__ densities, const real_t* __restrict__ b, const real_t* __restrict__ c,
+						 const real_t* __restrict__ e, const density_layout_t dens_l, index_t yz)
+{
+	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+	const index_t n = dens_l | noarr::get_length<'x'>();
+
+	auto diag_l = noarr::scalar<real_t>() ^ noarr::vector<'s'>(substrates_count) ^ noarr::vector<'i'>(n);
+
+	for (index_t i = 1; i < n; i++)
+	{
+#pragma omp simd
+		for (index_t s = 0; s < substrates_count; s++)
+		{
+			(dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i, s)) =
+				(dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i, s))
+				- (diag_l | noarr::get_at<'i', 's'>(e, i - 1, s))
+					  * (dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i - 1, s));
+		}
+	}
+
+#pragma omp simd
+	for (index_t s = 0; s < substrates_count; s++)
+	{
+		(dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, n - 1, s)) =
+			(dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, n - 1, s))
+			* (diag_l | noarr::get_at<'i', 's'>(b, n - 1, s));
+	}
+
+	for (index_t i = n - 2; i >= 0; i--)
+	{
+#pragma omp simd
+		for (index_t s = 0; s < substrates_count; s++)
+		{
+			(dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i, s)) =
+				((dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i, s))
+				 - c[s] * (dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i + 1, s)))
+				* (diag_l | noarr::get_at<'i', 's'>(b, i, s));
+		}
+	}
+}
+
+// Solves all y lines of the z slab
+template <typename index_t, typename real_t, typename density_layout_t>
+inline void solve_slab_y(real_t* __restrict__ densities, const real_t* __restrict__ b, const real_t* __restrict__ c,
+						 const real_t* __restrict__ e, const density_layout_t dens_l, index_t z)
+{
+	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+	const index_t n = dens_l | noarr::get_length<'y'>();
+	const index_t x_len = dens_l | noarr::get_length<'x'>();
+
+	auto diag_l = noarr::scalar<real_t>() ^ noarr::vector<'s'>(substrates_count) ^ noarr::vector<'i'>(n);
+
+	for (index_t i = 1; i < n; i++)
+	{
+		for (index_t x = 0; x < x_len; x++)
+		{
+#pragma omp simd
+			for (index_t s = 0; s < substrates_count; s++)
+			{
+				(dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, z, i, x, s)) =
+					(dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, z, i, x, s))
+					- (diag_l | noarr::get_at<'i', 's'>(e, i - 1, s))
+						  * (dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, z, i - 1, x, s));
+			}
+		}
+	}
+
+	for (index_t x = 0; x < x_len; x++)
+	{
+#pragma omp simd
+		for (index_t s = 0; s < substrates_count; s++)
+		{
+			(dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, z, n - 1, x, s)) =
+				(dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, z, n - 1, x, s))
+				* (diag_l | noarr::get_at<'i', 's'>(b, n - 1, s));
+		}
+	}
+
+	for (index_t i = n - 2; i >= 0; i--)
+	{
+		for (index_t x = 0; x < x_len; x++)
+		{
+#pragma omp simd
+			for (index_t s = 0; s < substrates_count; s++)
+			{
+				(dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, z, i, x, s)) =
+					((dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, z, i, x, s))
+					 - c[s] * (dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, z, i + 1, x, s)))
+					* (diag_l | noarr::get_at<'i', 's'>(b, i, s));
+			}
+		}
+	}
+}
+
+// Slice kernels solve a whole sweep of the densities buffer described by the layout; they contain orphaned omp for
+// constructs, so they have to be called from a parallel region
+
+template <typename index_t, typename real_t, typename density_layout_t>
+void solve_slice_x_1d(real_t* __restrict__ densities, const real_t* __restrict__ b, const real_t* __restrict__ c,
+					  const real_t* __restrict__ e, const density_layout_t dens_l, std::size_t work_items)
+{
+	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+	const index_t n = dens_l | noarr::get_length<'x'>();
+
+	auto diag_l = noarr::scalar<real_t>() ^ noarr::vector<'s'>(substrates_count) ^ noarr::vector<'i'>(n);
+
+	for (index_t i = 1; i < n; i++)
+	{
+#pragma omp for schedule(static, work_items) nowait
+		for (index_t s = 0; s < substrates_count; s++)
+		{
+			(dens_l | noarr::get_at<'x', 's'>(densities, i, s)) =
+				(dens_l | noarr::get_at<'x', 's'>(densities, i, s))
+				- (diag_l | noarr::get_at<'i', 's'>(e, i - 1, s))
+					  * (dens_l | noarr::get_at<'x', 's'>(densities, i - 1, s));
+		}
+	}
+
+#pragma omp for schedule(static, work_items) nowait
+	for (index_t s = 0; s < substrates_count; s++)
+	{
+		(dens_l | noarr::get_at<'x', 's'>(densities, n - 1, s)) =
+			(dens_l | noarr::get_at<'x', 's'>(densities, n - 1, s)) * (diag_l | noarr::get_at<'i', 's'>(b, n - 1, s));
+	}
+
+	for (index_t i = n - 2; i >= 0; i--)
+	{
+#pragma omp for schedule(static, work_items) nowait
+		for (index_t s = 0; s < substrates_count; s++)
+		{
+			(dens_l | noarr::get_at<'x', 's'>(densities, i, s)) =
+				((dens_l | noarr::get_at<'x', 's'>(densities, i, s))
+				 - c[s] * (dens_l | noarr::get_at<'x', 's'>(densities, i + 1, s)))
+				* (diag_l | noarr::get_at<'i', 's'>(b, i, s));
+		}
+	}
+}
+
+template <typename index_t, typename real_t, typename density_layout_t>
+void solve_slice_x_2d_and_3d(real_t* __restrict__ densities, const real_t* __restrict__ b, const real_t* __restrict__ c,
+							 const real_t* __restrict__ e, const density_layout_t dens_l, std::size_t work_items)
+{
+	const index_t m = dens_l | noarr::get_length<'m'>();
+
+#pragma omp for schedule(static, work_items)
+	for (index_t yz = 0; yz < m; yz++)
+	{
+		solve_line_x<index_t>(densities, b, c, e, dens_l, yz);
+	}
+}
+
+template <typename index_t, typename real_t, typename density_layout_t>
+void solve_slice_y_2d(real_t* __restrict__ densities, const real_t* __restrict__ b, const real_t* __restrict__ c,
+					  const real_t* __restrict__ e, const density_layout_t dens_l, std::size_t work_items)
+{
+	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+	const index_t n = dens_l | noarr::get_length<'y'>();
+	const index_t x_len = dens_l | noarr::get_length<'x'>();
+
+	auto diag_l = noarr::scalar<real_t>() ^ noarr::vector<'s'>(substrates_count) ^ noarr::vector<'i'>(n);
+
+	for (index_t i = 1; i < n; i++)
+	{
+#pragma omp for collapse(2) schedule(static, work_items) nowait
+		for (index_t x = 0; x < x_len; x++)
+		{
+			for (index_t s = 0; s < substrates_count; s++)
+			{
+				(dens_l | noarr::get_at<'y', 'x', 's'>(densities, i, x, s)) =
+					(dens_l | noarr::get_at<'y', 'x', 's'>(densities, i, x, s))
+					- (diag_l | noarr::get_at<'i', 's'>(e, i - 1, s))
+						  * (dens_l | noarr::get_at<'y', 'x', 's'>(densities, i - 1, x, s));
+			}
+		}
+	}
+
+#pragma omp for collapse(2) schedule(static, work_items) nowait
+	for (index_t x = 0; x < x_len; x++)
+	{
+		for (index_t s = 0; s < substrates_count; s++)
+		{
+			(dens_l | noarr::get_at<'y', 'x', 's'>(densities, n - 1, x, s)) =
+				(dens_l | noarr::get_at<'y', 'x', 's'>(densities, n - 1, x, s))
+				* (diag_l | noarr::get_at<'i', 's'>(b, n - 1, s));
+		}
+	}
+
+	for (index_t i = n - 2; i >= 0; i--)
+	{
+#pragma omp for collapse(2) schedule(static, work_items) nowait
+		for (index_t x = 0; x < x_len; x++)
+		{
+			for (index_t s = 0; s < substrates_count; s++)
+			{
+				(dens_l | noarr::get_at<'y', 'x', 's'>(densities, i, x, s)) =
+					((dens_l | noarr::get_at<'y', 'x', 's'>(densities, i, x, s))
+					 - c[s] * (dens_l | noarr::get_at<'y', 'x', 's'>(densities, i + 1, x, s)))
+					* (diag_l | noarr::get_at<'i', 's'>(b, i, s));
+			}
+		}
+	}
+}
+
+template <typename index_t, typename real_t, typename density_layout_t>
+void solve_slice_y_3d(real_t* __restrict__ densities, const real_t* __restrict__ b, const real_t* __restrict__ c,
+					  const real_t* __restrict__ e, const density_layout_t dens_l, std::size_t work_items)
+{
+	const index_t z_len = dens_l | noarr::get_length<'z'>();
+
+#pragma omp for schedule(static, work_items)
+	for (index_t z = 0; z < z_len; z++)
+	{
+		solve_slab_y<index_t>(densities, b, c, e, dens_l, z);
+	}
+}
+
+template <typename index_t, typename real_t, typename density_layout_t>
+void solve_slice_z_3d(real_t* __restrict__ densities, const real_t* __restrict__ b, const real_t* __restrict__ c,
+					  const real_t* __restrict__ e, const density_layout_t dens_l, std::size_t work_items)
+{
+	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+	const index_t n = dens_l | noarr::get_length<'z'>();
+	const index_t y_len = dens_l | noarr::get_length<'y'>();
+	const index_t x_len = dens_l | noarr::get_length<'x'>();
+
+	auto diag_l = noarr::scalar<real_t>() ^ noarr::vector<'s'>(substrates_count) ^ noarr::vector<'i'>(n);
+
+	for (index_t i = 1; i < n; i++)
+	{
+#pragma omp for collapse(3) schedule(static, work_items) nowait
+		for (index_t y = 0; y < y_len; y++)
+		{
+			for (index_t x = 0; x < x_len; x++)
+			{
+				for (index_t s = 0; s < substrates_count; s++)
+				{
+					(dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, i, y, x, s)) =
+						(dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, i, y, x, s))
+						- (diag_l | noarr::get_at<'i', 's'>(e, i - 1, s))
+							  * (dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, i - 1, y, x, s));
+				}
+			}
+		}
+	}
+
+#pragma omp for collapse(3) schedule(static, work_items) nowait
+	for (index_t y = 0; y < y_len; y++)
+	{
+		for (index_t x = 0; x < x_len; x++)
+		{
+			for (index_t s = 0; s < substrates_count; s++)
+			{
+				(dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, n - 1, y, x, s)) =
+					(dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, n - 1, y, x, s))
+					* (diag_l | noarr::get_at<'i', 's'>(b, n - 1, s));
+			}
+		}
+	}
+
+	for (index_t i = n - 2; i >= 0; i--)
+	{
+#pragma omp for collapse(3) schedule(static, work_items) nowait
+		for (index_t y = 0; y < y_len; y++)
+		{
+			for (index_t x = 0; x < x_len; x++)
+			{
+				for (index_t s = 0; s < substrates_count; s++)
+				{
+					(dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, i, y, x, s)) =
+						((dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, i, y, x, s))
+						 - c[s] * (dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, i + 1, y, x, s)))
+						* (diag_l | noarr::get_at<'i', 's'>(b, i, s));
+				}
+			}
+		}
+	}
+}
+
+// Prefetches the rows [begin, end) of the plane i
+template <typename index_t, typename real_t, typename density_layout_t>
+void prefetch_plane_rows(real_t* __restrict__ densities, const density_layout_t dens_l, index_t i, index_t begin,
+						 index_t end)
+{
+	constexpr std::size_t cache_line_size = 64;
+
+	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+
+	const char* first = (const char*)&(dens_l | noarr::get_at<'z', 'm', 's'>(densities, i, begin, 0));
+	const char* last =
+		(const char*)&(dens_l | noarr::get_at<'z', 'm', 's'>(densities, i, end - 1, substrates_count - 1));
+
+	for (; first <= last; first += cache_line_size)
+		__builtin_prefetch(first, 1, 3);
+}
+
+template <typename index_t, typename real_t, typename density_layout_t>
+void solve_slice_z_3d_tiled(real_t* __restrict__ densities, const real_t* __restrict__ b, const real_t* __restrict__ c,
+							const real_t* __restrict__ e, const density_layout_t dens_l, std::size_t tile_size)
+{
+	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+	const index_t n = dens_l | noarr::get_length<'z'>();
+	const index_t m = dens_l | noarr::get_length<'m'>();
+
+	const index_t tiles = (m + tile_size - 1) / tile_size;
+
+	auto diag_l = noarr::scalar<real_t>() ^ noarr::vector<'s'>(substrates_count) ^ noarr::vector<'i'>(n);
+
+#pragma omp for schedule(static)
+	for (index_t tile = 0; tile < tiles; tile++)
+	{
+		const index_t begin = tile * tile_size;
+		const index_t end = std::min<index_t>(begin + tile_size, m);
+
+		for (index_t i = 1; i < n; i++)
+		{
+			if (i + 1 < n)
+				prefetch_plane_rows(densities, dens_l, i + 1, begin, end);
+
+			for (index_t yx = begin; yx < end; yx++)
+			{
+#pragma omp simd
+				for (index_t s = 0; s < substrates_count; s++)
+				{
+					(dens_l | noarr::get_at<'z', 'm', 's'>(densities, i, yx, s)) =
+						(dens_l | noarr::get_at<'z', 'm', 's'>(densities, i, yx, s))
+						- (diag_l | noarr::get_at<'i', 's'>(e, i - 1, s))
+							  * (dens_l | noarr::get_at<'z', 'm', 's'>(densities, i - 1, yx, s));
+				}
+			}
+		}
+
+		for (index_t yx = begin; yx < end; yx++)
+		{
+#pragma omp simd
+			for (index_t s = 0; s < substrates_count; s++)
+			{
+				(dens_l | noarr::get_at<'z', 'm', 's'>(densities, n - 1, yx, s)) =
+					(dens_l | noarr::get_at<'z', 'm', 's'>(densities, n - 1, yx, s))
+					* (diag_l | noarr::get_at<'i', 's'>(b, n - 1, s));
+			}
+		}
+
+		for (index_t i = n - 2; i >= 0; i--)
+		{
+			if (i > 0)
+				prefetch_plane_rows(densities, dens_l, i - 1, begin, end);
+
+			for (index_t yx = begin; yx < end; yx++)
+			{
+#pragma omp simd
+				for (index_t s = 0; s < substrates_count; s++)
+				{
+					(dens_l | noarr::get_at<'z', 'm', 's'>(densities, i, yx, s)) =
+						((dens_l | noarr::get_at<'z', 'm', 's'>(densities, i, yx, s))
+						 - c[s] * (dens_l | noarr::get_at<'z', 'm', 's'>(densities, i + 1, yx, s)))
+						* (diag_l | noarr::get_at<'i', 's'>(b, i, s));
+				}
+			}
+		}
+	}
+}
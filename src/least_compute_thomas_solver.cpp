@@ -1,20 +1,37 @@
 #include "least_compute_thomas_solver.h"
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <fstream>
 #include <iostream>
+#include <omp.h>
+#include <thread>
 
+#include "least_compute_thomas_kernels.h"
 #include "solver_utils.h"
 
-template <typename real_t>
-void least_compute_thomas_solver<real_t>::precompute_values(std::unique_ptr<real_t[]>& b, std::unique_ptr<real_t[]>& c,
-															std::unique_ptr<real_t[]>& e, index_t shape, index_t dims,
-															index_t n, index_t copies)
+template <typename real_t, typename index_t>
+void least_compute_thomas_solver<real_t, index_t>::precompute_values(aligned_buffer<real_t>& b,
+																	 aligned_buffer<real_t>& c,
+																	 aligned_buffer<real_t>& e, index_t shape,
+																	 index_t dims, index_t n, index_t copies)
 {
-	b = std::make_unique<real_t[]>(n * problem_.substrates_count * copies);
-	e = std::make_unique<real_t[]>((n - 1) * problem_.substrates_count * copies);
-	c = std::make_unique<real_t[]>(problem_.substrates_count * copies);
+	const std::size_t b_size = n * problem_.substrates_count * copies;
+	const std::size_t e_size = (n - 1) * problem_.substrates_count * copies;
+	const std::size_t c_size = problem_.substrates_count * copies;
+
+	b = allocator_.allocate<real_t>(b_size);
+	e = allocator_.allocate<real_t>(e_size);
+	c = allocator_.allocate<real_t>(c_size);
+
+	const std::string key = factorization_cache::make_key("lstc", sizeof(real_t), shape, dims, n, copies, problem_.dt,
+														  problem_.diffusion_coefficients, problem_.decay_rates);
+
+	if (cache_.load(key, { std::as_writable_bytes(std::span(b.get(), b_size)),
+						   std::as_writable_bytes(std::span(e.get(), e_size)),
+						   std::as_writable_bytes(std::span(c.get(), c_size)) }))
+		return;
 
 	auto layout = noarr::scalar<real_t>() ^ noarr::vector<'s'>() ^ noarr::vector<'x'>() ^ noarr::vector<'i'>()
 				  ^ noarr::set_length<'i'>(n) ^ noarr::set_length<'x'>(copies)
@@ -67,29 +84,73 @@ void least_compute_thomas_solver<real_t>::precompute_values(std::unique_ptr<real
 						c[x * problem_.substrates_count + s] * b_diag.template at<'i', 'x', 's'>(i - 1, x, s);
 				}
 	}
+
+	cache_.store(key, { std::as_bytes(std::span(b.get(), b_size)), std::as_bytes(std::span(e.get(), e_size)),
+						std::as_bytes(std::span(c.get(), c_size)) });
+}
+
+template <typename real_t, typename index_t>
+void least_compute_thomas_solver<real_t, index_t>::resolve_padding(std::size_t density_bytes)
+{
+	auto [pad_x, pad_y] =
+		padding_.get(problem_.dims, problem_.nx, problem_.ny, problem_.substrates_count * density_bytes);
+
+	pad_x_ = pad_x;
+	pad_y_ = pad_y;
 }
 
-template <typename real_t>
-void least_compute_thomas_solver<real_t>::prepare(const max_problem_t& problem)
+template <typename real_t, typename index_t>
+std::size_t least_compute_thomas_solver<real_t, index_t>::get_substrates_size(const max_problem_t& problem,
+																			   std::size_t density_bytes) const
 {
-	problem_ = problems::cast<std::int32_t, real_t>(problem);
-	substrates_ = std::make_unique<real_t[]>(problem_.nx * problem_.ny * problem_.nz * problem_.substrates_count);
+	auto [pad_x, pad_y] = padding_.get(problem.dims, problem.nx, problem.ny, problem.substrates_count * density_bytes);
+
+	return problem.substrates_count * (problem.nx + pad_x) * (problem.ny + pad_y) * problem.nz;
+}
+
+template <typename real_t, typename index_t>
+std::size_t least_compute_thomas_solver<real_t, index_t>::allocated_elements(const max_problem_t& problem) const
+{
+	return get_substrates_size(problem, sizeof(real_t));
+}
+
+template <typename real_t, typename index_t>
+void least_compute_thomas_solver<real_t, index_t>::prepare(const max_problem_t& problem)
+{
+	problem_ = problems::cast<index_t, real_t>(problem);
+
+	resolve_padding(sizeof(real_t));
+	substrates_ = allocator_.allocate<real_t>(get_substrates_size());
 
 	// Initialize substrates
 
 	auto substrates_layout = get_substrates_layout<3>(problem_);
 
+	// the x and y sweeps distribute z slabs (y lines in 2D) among the threads
+	if (problem_.dims == 3)
+		solver_utils::first_touch<'z'>(substrates_layout, substrates_.get(), work_items_);
+	else
+		solver_utils::first_touch<'y'>(substrates_layout, substrates_.get(), work_items_);
+
 	solver_utils::initialize_substrate(substrates_layout, substrates_.get(), problem_);
 }
 
-template <typename real_t>
-void least_compute_thomas_solver<real_t>::tune(const nlohmann::json& params)
+template <typename real_t, typename index_t>
+void least_compute_thomas_solver<real_t, index_t>::tune(const nlohmann::json& params)
 {
+	allocator_.tune(params);
+	cache_.tune(params);
+	padding_.tune(params);
+
 	work_items_ = params.contains("work_items") ? (std::size_t)params["work_items"] : 1;
+	z_tile_size_ = params.contains("z_tile_size") ? (std::size_t)params["z_tile_size"] : 0;
+	pipelined_ = params.contains("pipelined") ? (bool)params["pipelined"] : false;
+	persistent_region_ = params.contains("persistent_region") ? (bool)params["persistent_region"] : false;
+	specialized_ = params.contains("specialized_kernels") ? (bool)params["specialized_kernels"] : true;
 }
 
-template <typename real_t>
-void least_compute_thomas_solver<real_t>::initialize()
+template <typename real_t, typename index_t>
+void least_compute_thomas_solver<real_t, index_t>::initialize()
 {
 	if (problem_.dims >= 1)
 		precompute_values(bx_, cx_, ex_, problem_.dx, problem_.dims, problem_.nx, 1);
@@ -97,356 +158,326 @@ void least_compute_thomas_solver<real_t>::initialize()
 		precompute_values(by_, cy_, ey_, problem_.dy, problem_.dims, problem_.ny, 1);
 	if (problem_.dims >= 3)
 		precompute_values(bz_, cz_, ez_, problem_.dz, problem_.dims, problem_.nz, 1);
-}
 
-template <typename real_t>
-template <std::size_t dims>
-auto least_compute_thomas_solver<real_t>::get_substrates_layout(const problem_t<index_t, real_t>& problem)
-{
-	if constexpr (dims == 1)
-		return noarr::scalar<real_t>() ^ noarr::vectors<'s', 'x'>(problem.substrates_count, problem.nx);
-	else if constexpr (dims == 2)
-		return noarr::scalar<real_t>()
-			   ^ noarr::vectors<'s', 'x', 'y'>(problem.substrates_count, problem.nx, problem.ny);
-	else if constexpr (dims == 3)
-		return noarr::scalar<real_t>()
-			   ^ noarr::vectors<'s', 'x', 'y', 'z'>(problem.substrates_count, problem.nx, problem.ny, problem.nz);
-}
-
-template <typename index_t, typename real_t, typename density_layout_t>
-void solve_slice_x_1d(real_t* __restrict__ densities, const real_t* __restrict__ b, const real_t* __restrict__ c,
-					  const real_t* __restrict__ e, const density_layout_t dens_l, std::size_t work_items)
-{
-	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
-	const index_t n = dens_l | noarr::get_length<'x'>();
-
-	auto diag_l = noarr::scalar<real_t>() ^ noarr::vector<'s'>(substrates_count) ^ noarr::vector<'i'>(n);
-
-	for (index_t i = 1; i < n; i++)
-	{
-#pragma omp for schedule(static, work_items) nowait
-		for (index_t s = 0; s < substrates_count; s++)
-		{
-			(dens_l | noarr::get_at<'x', 's'>(densities, i, s)) =
-				(dens_l | noarr::get_at<'x', 's'>(densities, i, s))
-				- (diag_l | noarr::get_at<'i', 's'>(e, i - 1, s))
-					  * (dens_l | noarr::get_at<'x', 's'>(densities, i - 1, s));
-		}
-	}
-
-#pragma omp for schedule(static, work_items) nowait
-	for (index_t s = 0; s < substrates_count; s++)
+	if (pipelined_)
 	{
-		(dens_l | noarr::get_at<'x', 's'>(densities, n - 1, s)) =
-			(dens_l | noarr::get_at<'x', 's'>(densities, n - 1, s)) * (diag_l | noarr::get_at<'i', 's'>(b, n - 1, s));
-	}
-
-	for (index_t i = n - 2; i >= 0; i--)
-	{
-#pragma omp for schedule(static, work_items) nowait
-		for (index_t s = 0; s < substrates_count; s++)
-		{
-			(dens_l | noarr::get_at<'x', 's'>(densities, i, s)) =
-				((dens_l | noarr::get_at<'x', 's'>(densities, i, s))
-				 - c[s] * (dens_l | noarr::get_at<'x', 's'>(densities, i + 1, s)))
-				* (diag_l | noarr::get_at<'i', 's'>(b, i, s));
-		}
+		xy_done_ = std::make_unique<plane_counter_t[]>(problem_.nz);
+		z_released_ = std::make_unique<plane_counter_t[]>(problem_.nz);
 	}
 }
 
+// Solves x and y sweeps of one z slab after another, so the y sweep finds the slab still in the cache
 template <typename index_t, typename real_t, typename density_layout_t>
-void solve_slice_x_2d_and_3d(real_t* __restrict__ densities, const real_t* __restrict__ b, const real_t* __restrict__ c,
-							 const real_t* __restrict__ e, const density_layout_t dens_l, std::size_t work_items)
+void solve_slice_xy_3d(real_t* __restrict__ densities, const real_t* __restrict__ bx, const real_t* __restrict__ cx,
+					   const real_t* __restrict__ ex, const real_t* __restrict__ by, const real_t* __restrict__ cy,
+					   const real_t* __restrict__ ey, const density_layout_t dens_l, std::size_t work_items)
 {
-	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
-	const index_t n = dens_l | noarr::get_length<'x'>();
-	const index_t m = dens_l | noarr::get_length<'m'>();
+	const index_t z_len = dens_l | noarr::get_length<'z'>();
+	const index_t y_len = dens_l | noarr::get_length<'y'>();
 
-	auto diag_l = noarr::scalar<real_t>() ^ noarr::vector<'s'>(substrates_count) ^ noarr::vector<'i'>(n);
+	auto x_dens_l = dens_l ^ noarr::merge_blocks<'z', 'y', 'm'>();
 
 #pragma omp for schedule(static, work_items)
-	for (index_t yz = 0; yz < m; yz++)
+	for (index_t z = 0; z < z_len; z++)
 	{
-		for (index_t i = 1; i < n; i++)
-		{
-#pragma omp simd
-			for (index_t s = 0; s < substrates_count; s++)
-			{
-				(dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i, s)) =
-					(dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i, s))
-					- (diag_l | noarr::get_at<'i', 's'>(e, i - 1, s))
-						  * (dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i - 1, s));
-			}
-		}
-
-#pragma omp simd
-		for (index_t s = 0; s < substrates_count; s++)
-		{
-			(dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, n - 1, s)) =
-				(dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, n - 1, s))
-				* (diag_l | noarr::get_at<'i', 's'>(b, n - 1, s));
-		}
+		for (index_t y = 0; y < y_len; y++)
+			solve_line_x<index_t>(densities, bx, cx, ex, x_dens_l, z * y_len + y);
 
-		for (index_t i = n - 2; i >= 0; i--)
-		{
-#pragma omp simd
-			for (index_t s = 0; s < substrates_count; s++)
-			{
-				(dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i, s)) =
-					((dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i, s))
-					 - c[s] * (dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i + 1, s)))
-					* (diag_l | noarr::get_at<'i', 's'>(b, i, s));
-			}
-		}
+		solve_slab_y<index_t>(densities, by, cy, ey, dens_l, z);
 	}
 }
 
-template <typename index_t, typename real_t, typename density_layout_t>
-void solve_slice_y_2d(real_t* __restrict__ densities, const real_t* __restrict__ b, const real_t* __restrict__ c,
-					  const real_t* __restrict__ e, const density_layout_t dens_l, std::size_t work_items)
+template <typename counter_t>
+void wait_for_counter(const counter_t& counter, std::size_t target)
+{
+	while (counter.value.load(std::memory_order_acquire) < target)
+		std::this_thread::yield();
+}
+
+// Solves multiple steps without barriers; x/y slab solves and z plane solves are ordered by per-plane counters
+template <typename index_t, typename real_t, typename density_layout_t, typename counter_t>
+void solve_iterations_pipelined(real_t* __restrict__ densities, const real_t* __restrict__ bx,
+								const real_t* __restrict__ cx, const real_t* __restrict__ ex,
+								const real_t* __restrict__ by, const real_t* __restrict__ cy,
+								const real_t* __restrict__ ey, const real_t* __restrict__ bz,
+								const real_t* __restrict__ cz, const real_t* __restrict__ ez, counter_t* xy_done,
+								counter_t* z_released, const density_layout_t dens_l, std::size_t work_items,
+								std::size_t iterations)
 {
 	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
-	const index_t n = dens_l | noarr::get_length<'y'>();
+	const index_t n = dens_l | noarr::get_length<'z'>();
+	const index_t y_len = dens_l | noarr::get_length<'y'>();
 	const index_t x_len = dens_l | noarr::get_length<'x'>();
 
+	const std::size_t threads = omp_get_num_threads();
+	const index_t thread = omp_get_thread_num();
+
+	auto x_dens_l = dens_l ^ noarr::merge_blocks<'z', 'y', 'm'>();
+	auto z_dens_l = dens_l ^ noarr::merge_blocks<'y', 'x', 'm'>();
+
 	auto diag_l = noarr::scalar<real_t>() ^ noarr::vector<'s'>(substrates_count) ^ noarr::vector<'i'>(n);
 
-	for (index_t i = 1; i < n; i++)
-	{
-#pragma omp for collapse(2) schedule(static, work_items) nowait
-		for (index_t x = 0; x < x_len; x++)
-		{
-			for (index_t s = 0; s < substrates_count; s++)
-			{
-				(dens_l | noarr::get_at<'y', 'x', 's'>(densities, i, x, s)) =
-					(dens_l | noarr::get_at<'y', 'x', 's'>(densities, i, x, s))
-					- (diag_l | noarr::get_at<'i', 's'>(e, i - 1, s))
-						  * (dens_l | noarr::get_at<'y', 'x', 's'>(densities, i - 1, x, s));
-			}
-		}
-	}
+	// each thread solves the same part of each z plane
+	const index_t begin = thread * (y_len * x_len) / threads;
+	const index_t end = (thread + 1) * (y_len * x_len) / threads;
 
-#pragma omp for collapse(2) schedule(static, work_items) nowait
-	for (index_t x = 0; x < x_len; x++)
+	for (std::size_t iteration = 0; iteration < iterations; iteration++)
 	{
-		for (index_t s = 0; s < substrates_count; s++)
+#pragma omp for schedule(static, work_items) nowait
+		for (index_t z = 0; z < n; z++)
 		{
-			(dens_l | noarr::get_at<'y', 'x', 's'>(densities, n - 1, x, s)) =
-				(dens_l | noarr::get_at<'y', 'x', 's'>(densities, n - 1, x, s))
-				* (diag_l | noarr::get_at<'i', 's'>(b, n - 1, s));
-		}
-	}
+			wait_for_counter(z_released[z], iteration * threads);
 
-	for (index_t i = n - 2; i >= 0; i--)
-	{
-#pragma omp for collapse(2) schedule(static, work_items) nowait
-		for (index_t x = 0; x < x_len; x++)
-		{
-			for (index_t s = 0; s < substrates_count; s++)
-			{
-				(dens_l | noarr::get_at<'y', 'x', 's'>(densities, i, x, s)) =
-					((dens_l | noarr::get_at<'y', 'x', 's'>(densities, i, x, s))
-					 - c[s] * (dens_l | noarr::get_at<'y', 'x', 's'>(densities, i + 1, x, s)))
-					* (diag_l | noarr::get_at<'i', 's'>(b, i, s));
-			}
-		}
-	}
-}
+			for (index_t y = 0; y < y_len; y++)
+				solve_line_x<index_t>(densities, bx, cx, ex, x_dens_l, z * y_len + y);
 
-template <typename index_t, typename real_t, typename density_layout_t>
-void solve_slice_y_3d(real_t* __restrict__ densities, const real_t* __restrict__ b, const real_t* __restrict__ c,
-					  const real_t* __restrict__ e, const density_layout_t dens_l, std::size_t work_items)
-{
-	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
-	const index_t n = dens_l | noarr::get_length<'y'>();
-	const index_t z_len = dens_l | noarr::get_length<'z'>();
-	const index_t x_len = dens_l | noarr::get_length<'x'>();
+			solve_slab_y<index_t>(densities, by, cy, ey, dens_l, z);
 
-	auto diag_l = noarr::scalar<real_t>() ^ noarr::vector<'s'>(substrates_count) ^ noarr::vector<'i'>(n);
+			xy_done[z].value.store(iteration + 1, std::memory_order_release);
+		}
 
-#pragma omp for schedule(static, work_items)
-	for (index_t z = 0; z < z_len; z++)
-	{
-		for (index_t i = 1; i < n; i++)
+		for (index_t i = 0; i < n; i++)
 		{
-			for (index_t x = 0; x < x_len; x++)
+			wait_for_counter(xy_done[i], iteration + 1);
+
+			if (i == 0)
+				continue;
+
+			for (index_t yx = begin; yx < end; yx++)
 			{
 #pragma omp simd
 				for (index_t s = 0; s < substrates_count; s++)
 				{
-					(dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, z, i, x, s)) =
-						(dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, z, i, x, s))
-						- (diag_l | noarr::get_at<'i', 's'>(e, i - 1, s))
-							  * (dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, z, i - 1, x, s));
+					(z_dens_l | noarr::get_at<'z', 'm', 's'>(densities, i, yx, s)) =
+						(z_dens_l | noarr::get_at<'z', 'm', 's'>(densities, i, yx, s))
+						- (diag_l | noarr::get_at<'i', 's'>(ez, i - 1, s))
+							  * (z_dens_l | noarr::get_at<'z', 'm', 's'>(densities, i - 1, yx, s));
 				}
 			}
 		}
 
-		for (index_t x = 0; x < x_len; x++)
+		for (index_t yx = begin; yx < end; yx++)
 		{
 #pragma omp simd
 			for (index_t s = 0; s < substrates_count; s++)
 			{
-				(dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, z, n - 1, x, s)) =
-					(dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, z, n - 1, x, s))
-					* (diag_l | noarr::get_at<'i', 's'>(b, n - 1, s));
+				(z_dens_l | noarr::get_at<'z', 'm', 's'>(densities, n - 1, yx, s)) =
+					(z_dens_l | noarr::get_at<'z', 'm', 's'>(densities, n - 1, yx, s))
+					* (diag_l | noarr::get_at<'i', 's'>(bz, n - 1, s));
 			}
 		}
 
 		for (index_t i = n - 2; i >= 0; i--)
 		{
-			for (index_t x = 0; x < x_len; x++)
+			for (index_t yx = begin; yx < end; yx++)
 			{
 #pragma omp simd
 				for (index_t s = 0; s < substrates_count; s++)
 				{
-					(dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, z, i, x, s)) =
-						((dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, z, i, x, s))
-						 - c[s] * (dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, z, i + 1, x, s)))
-						* (diag_l | noarr::get_at<'i', 's'>(b, i, s));
+					(z_dens_l | noarr::get_at<'z', 'm', 's'>(densities, i, yx, s)) =
+						((z_dens_l | noarr::get_at<'z', 'm', 's'>(densities, i, yx, s))
+						 - cz[s] * (z_dens_l | noarr::get_at<'z', 'm', 's'>(densities, i + 1, yx, s)))
+						* (diag_l | noarr::get_at<'i', 's'>(bz, i, s));
 				}
 			}
+
+			// the plane i + 1 is not read anymore
+			z_released[i + 1].value.fetch_add(1, std::memory_order_release);
 		}
+
+		z_released[0].value.fetch_add(1, std::memory_order_release);
 	}
 }
 
-template <typename index_t, typename real_t, typename density_layout_t>
-void solve_slice_z_3d(real_t* __restrict__ densities, const real_t* __restrict__ b, const real_t* __restrict__ c,
-					  const real_t* __restrict__ e, const density_layout_t dens_l, std::size_t work_items)
+template <typename real_t, typename index_t>
+void least_compute_thomas_solver<real_t, index_t>::solve_x()
 {
-	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
-	const index_t n = dens_l | noarr::get_length<'z'>();
-	const index_t y_len = dens_l | noarr::get_length<'y'>();
-	const index_t x_len = dens_l | noarr::get_length<'x'>();
-
-	auto diag_l = noarr::scalar<real_t>() ^ noarr::vector<'s'>(substrates_count) ^ noarr::vector<'i'>(n);
+#pragma omp parallel
+	solve_x_omp();
+}
 
-	for (index_t i = 1; i < n; i++)
-	{
-#pragma omp for collapse(3) schedule(static, work_items) nowait
-		for (index_t y = 0; y < y_len; y++)
+template <typename real_t, typename index_t>
+void least_compute_thomas_solver<real_t, index_t>::solve_x_omp()
+{
+	solver_utils::dispatch_substrates_count(problem_.substrates_count, specialized_, [&](auto substrates_count) {
+		if (problem_.dims == 1)
 		{
-			for (index_t x = 0; x < x_len; x++)
-			{
-				for (index_t s = 0; s < substrates_count; s++)
-				{
-					(dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, i, y, x, s)) =
-						(dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, i, y, x, s))
-						- (diag_l | noarr::get_at<'i', 's'>(e, i - 1, s))
-							  * (dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, i - 1, y, x, s));
-				}
-			}
+			solve_slice_x_1d<index_t>(substrates_.get(), bx_.get(), cx_.get(), ex_.get(),
+									  get_substrates_layout<1>(problem_, substrates_count), work_items_);
 		}
-	}
+		else if (problem_.dims == 2)
+		{
+			solve_slice_x_2d_and_3d<index_t>(substrates_.get(), bx_.get(), cx_.get(), ex_.get(),
+											 get_substrates_layout<2>(problem_, substrates_count)
+												 ^ noarr::rename<'y', 'm'>(),
+											 work_items_);
+		}
+		else if (problem_.dims == 3)
+		{
+			solve_slice_x_2d_and_3d<index_t>(substrates_.get(), bx_.get(), cx_.get(), ex_.get(),
+											 get_substrates_layout<3>(problem_, substrates_count)
+												 ^ noarr::merge_blocks<'z', 'y', 'm'>(),
+											 work_items_);
+		}
+	});
+}
 
-#pragma omp for collapse(3) schedule(static, work_items) nowait
-	for (index_t y = 0; y < y_len; y++)
-	{
-		for (index_t x = 0; x < x_len; x++)
+template <typename real_t, typename index_t>
+void least_compute_thomas_solver<real_t, index_t>::solve_y()
+{
+#pragma omp parallel
+	solve_y_omp();
+}
+
+template <typename real_t, typename index_t>
+void least_compute_thomas_solver<real_t, index_t>::solve_y_omp()
+{
+	solver_utils::dispatch_substrates_count(problem_.substrates_count, specialized_, [&](auto substrates_count) {
+		if (problem_.dims == 2)
 		{
-			for (index_t s = 0; s < substrates_count; s++)
-			{
-				(dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, n - 1, y, x, s)) =
-					(dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, n - 1, y, x, s))
-					* (diag_l | noarr::get_at<'i', 's'>(b, n - 1, s));
-			}
+			solve_slice_y_2d<index_t>(substrates_.get(), by_.get(), cy_.get(), ey_.get(),
+									  get_substrates_layout<2>(problem_, substrates_count), work_items_);
 		}
-	}
+		else if (problem_.dims == 3)
+		{
+			solve_slice_y_3d<index_t>(substrates_.get(), by_.get(), cy_.get(), ey_.get(),
+									  get_substrates_layout<3>(problem_, substrates_count), work_items_);
+		}
+	});
+}
 
-	for (index_t i = n - 2; i >= 0; i--)
-	{
-#pragma omp for collapse(3) schedule(static, work_items) nowait
-		for (index_t y = 0; y < y_len; y++)
+template <typename real_t, typename index_t>
+void least_compute_thomas_solver<real_t, index_t>::solve_z()
+{
+#pragma omp parallel
+	solve_z_omp();
+}
+
+template <typename real_t, typename index_t>
+void least_compute_thomas_solver<real_t, index_t>::solve_z_omp()
+{
+	if (problem_.dims != 3)
+		return;
+
+	solver_utils::dispatch_substrates_count(problem_.substrates_count, specialized_, [&](auto substrates_count) {
+		if (z_tile_size_ > 0)
 		{
-			for (index_t x = 0; x < x_len; x++)
-			{
-				for (index_t s = 0; s < substrates_count; s++)
-				{
-					(dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, i, y, x, s)) =
-						((dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, i, y, x, s))
-						 - c[s] * (dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, i + 1, y, x, s)))
-						* (diag_l | noarr::get_at<'i', 's'>(b, i, s));
-				}
-			}
+			solve_slice_z_3d_tiled<index_t>(substrates_.get(), bz_.get(), cz_.get(), ez_.get(),
+											get_substrates_layout<3>(problem_, substrates_count)
+												^ noarr::merge_blocks<'y', 'x', 'm'>(),
+											z_tile_size_);
 		}
-	}
+		else
+		{
+			solve_slice_z_3d<index_t>(substrates_.get(), bz_.get(), cz_.get(), ez_.get(),
+									  get_substrates_layout<3>(problem_, substrates_count), work_items_);
+		}
+	});
 }
 
-template <typename real_t>
-void least_compute_thomas_solver<real_t>::solve_x()
+template <typename real_t, typename index_t>
+void least_compute_thomas_solver<real_t, index_t>::solve_omp()
 {
-	if (problem_.dims == 1)
+	if (problem_.dims == 3)
 	{
-#pragma omp parallel
-		solve_slice_x_1d<index_t>(substrates_.get(), bx_.get(), cx_.get(), ex_.get(),
-								  get_substrates_layout<1>(problem_), work_items_);
+		solver_utils::dispatch_substrates_count(problem_.substrates_count, specialized_, [&](auto substrates_count) {
+			solve_slice_xy_3d<index_t>(substrates_.get(), bx_.get(), cx_.get(), ex_.get(), by_.get(), cy_.get(),
+									   ey_.get(), get_substrates_layout<3>(problem_, substrates_count), work_items_);
+		});
+		solve_z_omp();
 	}
-	else if (problem_.dims == 2)
+	else
 	{
-#pragma omp parallel
-		solve_slice_x_2d_and_3d<index_t>(substrates_.get(), bx_.get(), cx_.get(), ex_.get(),
-										 get_substrates_layout<2>(problem_) ^ noarr::rename<'y', 'm'>(), work_items_);
+		solve_x_omp();
+#pragma omp barrier
+		solve_y_omp();
 	}
-	else if (problem_.dims == 3)
-	{
+}
+
+template <typename real_t, typename index_t>
+void least_compute_thomas_solver<real_t, index_t>::solve()
+{
 #pragma omp parallel
-		solve_slice_x_2d_and_3d<index_t>(substrates_.get(), bx_.get(), cx_.get(), ex_.get(),
-										 get_substrates_layout<3>(problem_) ^ noarr::merge_blocks<'z', 'y', 'm'>(),
-										 work_items_);
-	}
+	solve_omp();
 }
 
-template <typename real_t>
-void least_compute_thomas_solver<real_t>::solve_y()
+template <typename real_t, typename index_t>
+void least_compute_thomas_solver<real_t, index_t>::solve_iterations(std::size_t iterations)
 {
-	if (problem_.dims == 2)
+	if (pipelined_ && problem_.dims == 3)
 	{
+		for (index_t z = 0; z < problem_.nz; z++)
+		{
+			xy_done_[z].value = 0;
+			z_released_[z].value = 0;
+		}
+
 #pragma omp parallel
-		solve_slice_y_2d<index_t>(substrates_.get(), by_.get(), cy_.get(), ey_.get(),
-								  get_substrates_layout<2>(problem_), work_items_);
+		solver_utils::dispatch_substrates_count(problem_.substrates_count, specialized_, [&](auto substrates_count) {
+			solve_iterations_pipelined<index_t>(substrates_.get(), bx_.get(), cx_.get(), ex_.get(), by_.get(),
+												cy_.get(), ey_.get(), bz_.get(), cz_.get(), ez_.get(), xy_done_.get(),
+												z_released_.get(), get_substrates_layout<3>(problem_, substrates_count),
+												work_items_, iterations);
+		});
 	}
-	else if (problem_.dims == 3)
+	else
 	{
-#pragma omp parallel
-		solve_slice_y_3d<index_t>(substrates_.get(), by_.get(), cy_.get(), ey_.get(),
-								  get_substrates_layout<3>(problem_), work_items_);
+		solve_steps(iterations);
 	}
 }
 
-template <typename real_t>
-void least_compute_thomas_solver<real_t>::solve_z()
+template <typename real_t, typename index_t>
+void least_compute_thomas_solver<real_t, index_t>::solve_steps(std::size_t iterations)
 {
+	if (persistent_region_)
+	{
 #pragma omp parallel
-	solve_slice_z_3d<index_t>(substrates_.get(), bz_.get(), cz_.get(), ez_.get(), get_substrates_layout<3>(problem_),
-							  work_items_);
+		for (std::size_t i = 0; i < iterations; i++)
+		{
+			solve_omp();
+#pragma omp barrier
+		}
+	}
+	else
+	{
+		tridiagonal_solver::solve_iterations(iterations);
+	}
 }
 
-template <typename real_t>
-void least_compute_thomas_solver<real_t>::save(const std::string& file) const
+template <typename real_t, typename index_t>
+void least_compute_thomas_solver<real_t, index_t>::save(const std::string& file) const
 {
-	auto dens_l = get_substrates_layout<3>(problem_);
-
 	std::ofstream out(file);
 
+	// access is overridden by the variants with their own layouts
 	for (index_t z = 0; z < problem_.nz; z++)
 		for (index_t y = 0; y < problem_.ny; y++)
 			for (index_t x = 0; x < problem_.nx; x++)
 			{
 				for (index_t s = 0; s < problem_.substrates_count; s++)
-					out << (dens_l | noarr::get_at<'s', 'x', 'y', 'z'>(substrates_.get(), s, x, y, z)) << " ";
+					out << access(s, x, y, z) << " ";
 				out << std::endl;
 			}
 
 	out.close();
 }
 
-template <typename real_t>
-double least_compute_thomas_solver<real_t>::access(std::size_t s, std::size_t x, std::size_t y, std::size_t z) const
+template <typename real_t, typename index_t>
+std::span<const std::byte> least_compute_thomas_solver<real_t, index_t>::substrates_memory() const
+{
+	return std::as_bytes(std::span(substrates_.get(), get_substrates_size()));
+}
+
+template <typename real_t, typename index_t>
+double least_compute_thomas_solver<real_t, index_t>::access(std::size_t s, std::size_t x, std::size_t y,
+															std::size_t z) const
 {
 	auto dens_l = get_substrates_layout<3>(problem_);
 
 	return (dens_l | noarr::get_at<'s', 'x', 'y', 'z'>(substrates_.get(), s, x, y, z));
 }
 
-template class least_compute_thomas_solver<float>;
-template class least_compute_thomas_solver<double>;
+template class least_compute_thomas_solver<float, std::int32_t>;
+template class least_compute_thomas_solver<float, std::int64_t>;
+template class least_compute_thomas_solver<double, std::int32_t>;
+template class least_compute_thomas_solver<double, std::int64_t>;
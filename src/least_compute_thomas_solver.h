@@ -1,9 +1,15 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <omp.h>
 
 #include <noarr/structures_extended.hpp>
 
+#include "aligned_allocator.h"
+#include "factorization_cache.h"
+#include "layout_padding.h"
 #include "tridiagonal_solver.h"
 
 /*
@@ -28,41 +34,167 @@ d_i'  == d_i - e_i*d_(i-1)                                    1 <  i <= n
 The backpropagation (2n multiplications + n subtractions):
 d_n'' == d_n'/b_n'
 d_i'' == (d_i' - c_i*d_(i+1)'')*b_i'                          n >  i >= 1
+
+The z dimension can be optionally solved in tiles of the (y, x) plane, where each tile goes through the whole forward
+and backward substitution at once. With the tile sized to the cache, the backward substitution reuses the data loaded
+by the forward substitution instead of streaming the whole 3D grid twice.
+
+A whole time step (solve) fuses the x and y sweeps: each z slab is solved in x and right after in y while it is
+still in the cache, so only the z sweep streams the grid separately.
+
+When multiple steps are solved in the pipelined mode, there is no barrier between the steps. A thread finishing the
+backward z substitution of a plane releases it, and the x/y slab solve of the next step starts on the plane as soon
+as all threads have released it. Similarly, the z sweep of a plane waits only for the x/y solve of that plane.
+Without the pipelining, the persistent region still solves multiple steps in a single parallel region with barriers
+between the sweeps.
+
+The sweeps are instantiated also for the substrate counts 1, 2, 4, 8 and 16 known at compile time, so the substrate
+loops of few substrates are fully unrolled instead of running a vector loop with a remainder. The runtime count falls
+back to the generic kernels ("specialized_kernels" param disables the specialization).
+
+The x lines and the xy planes of the densities can be padded to avoid the aliasing of power-of-two strides (see
+layout_padding).
 */
 
-template <typename real_t>
+template <typename real_t, typename index_t>
 class least_compute_thomas_solver : public tridiagonal_solver
 {
-	using index_t = std::int32_t;
-
+protected:
 	problem_t<index_t, real_t> problem_;
 
-	std::unique_ptr<real_t[]> substrates_;
+	aligned_allocator allocator_;
+	factorization_cache cache_;
+	layout_padding padding_;
+
+	// the x points appended to each x line and the x lines appended to each xy plane
+	index_t pad_x_ = 0, pad_y_ = 0;
 
-	std::unique_ptr<real_t[]> bx_, cx_, ex_;
-	std::unique_ptr<real_t[]> by_, cy_, ey_;
-	std::unique_ptr<real_t[]> bz_, cz_, ez_;
+	aligned_buffer<real_t> substrates_;
+
+	aligned_buffer<real_t> bx_, cx_, ex_;
+	aligned_buffer<real_t> by_, cy_, ey_;
+	aligned_buffer<real_t> bz_, cz_, ez_;
 
 	std::size_t work_items_;
+	std::size_t z_tile_size_;
+
+	bool pipelined_;
+	bool persistent_region_;
+
+	// whether the sweeps use the kernels specialized for the substrates count
+	bool specialized_;
 
-	void precompute_values(std::unique_ptr<real_t[]>& b, std::unique_ptr<real_t[]>& c, std::unique_ptr<real_t[]>& e,
+	struct alignas(64) plane_counter_t
+	{
+		std::atomic<std::size_t> value;
+	};
+
+	// per z plane: the number of finished x/y slab solves and the number of thread releases from the z sweep
+	std::unique_ptr<plane_counter_t[]> xy_done_, z_released_;
+
+	void precompute_values(aligned_buffer<real_t>& b, aligned_buffer<real_t>& c, aligned_buffer<real_t>& e,
 						   index_t shape, index_t dims, index_t n, index_t copies);
 
+	// Resolves the padding of the layouts for the densities of the given size
+	void resolve_padding(std::size_t density_bytes);
+
+	// The padding is sliced away, so the layouts have the grid lengths; a 1D line and a 2D plane are not padded
+	std::size_t get_substrates_size() const
+	{
+		return (std::size_t)problem_.substrates_count * (problem_.nx + pad_x_) * (problem_.ny + pad_y_) * problem_.nz;
+	}
+
+	// The same size for a problem not prepared yet, with the padding it would resolve for the densities of the size
+	std::size_t get_substrates_size(const max_problem_t& problem, std::size_t density_bytes) const;
+
+	// The substrates count is either index_t or noarr::lit for the specialized kernels
+	template <std::size_t dims, typename substrates_count_t>
+	auto get_substrates_layout(const problem_t<index_t, real_t>& problem, substrates_count_t substrates_count) const
+	{
+		if constexpr (dims == 1)
+			return noarr::scalar<real_t>() ^ noarr::vectors<'s', 'x'>(substrates_count, problem.nx);
+		else if constexpr (dims == 2)
+			return noarr::scalar<real_t>()
+				   ^ noarr::vectors<'s', 'x', 'y'>(substrates_count, problem.nx + pad_x_, problem.ny)
+				   ^ noarr::slice<'x'>(0, problem.nx);
+		else if constexpr (dims == 3)
+			return noarr::scalar<real_t>()
+				   ^ noarr::vectors<'s', 'x', 'y', 'z'>(substrates_count, problem.nx + pad_x_, problem.ny + pad_y_,
+														problem.nz)
+				   ^ noarr::slice<'x'>(0, problem.nx) ^ noarr::slice<'y'>(0, problem.ny);
+	}
+
 	template <std::size_t dims>
-	static auto get_substrates_layout(const problem_t<index_t, real_t>& problem);
+	auto get_substrates_layout(const problem_t<index_t, real_t>& problem) const
+	{
+		return get_substrates_layout<dims>(problem, problem.substrates_count);
+	}
+
+	// A 2D problem has a single y slab, so the y sweeps split it into this many blocks among the threads; len is the
+	// length of the split dimension. Has to be called inside the parallel region.
+	index_t get_slab_blocks(index_t len) const
+	{
+		return problem_.dims == 2 ? std::min<index_t>(omp_get_num_threads(), len) : 1;
+	}
+
+	// The sweeps without their own parallel region, so they can be called from an enclosing one; the variants
+	// override them with their own kernels
+	virtual void solve_x_omp();
+	virtual void solve_y_omp();
+	virtual void solve_z_omp();
+	virtual void solve_omp();
+
+	// Solves the steps in a single parallel region with the persistent region, otherwise each step in its own
+	void solve_steps(std::size_t iterations);
 
 public:
 	void prepare(const max_problem_t& problem) override;
 
 	void tune(const nlohmann::json& params) override;
 
+	std::size_t allocated_elements(const max_problem_t& problem) const override;
+
 	void initialize() override;
 
 	void solve_x() override;
 	void solve_y() override;
 	void solve_z() override;
 
+	void solve() override;
+
+	void solve_iterations(std::size_t iterations) override;
+
 	void save(const std::string& file) const override;
 
+	std::span<const std::byte> substrates_memory() const override;
+
 	double access(std::size_t s, std::size_t x, std::size_t y, std::size_t z) const override;
 };
+
+/*
+The base of the solvers of the least_compute systems with their own density layouts or kernels. They implement only
+the *_omp sweeps (and access, substrates_memory for their own layouts); the sweep wrappers and save of
+least_compute_thomas_solver call them. Their 3D layouts serve problems of any dimensionality, the missing dimensions
+have unit lengths.
+
+A step solves the x, y and z sweeps one after another. Multiple steps run in a persistent region if requested; the
+pipelined mode relies on the least_compute layout and kernels, so it is not available.
+*/
+
+template <typename real_t, typename index_t>
+class least_compute_variant : public least_compute_thomas_solver<real_t, index_t>
+{
+protected:
+	// Some kernels end without a barrier, so the sweeps are separated by barriers
+	void solve_omp() override
+	{
+		this->solve_x_omp();
+#pragma omp barrier
+		this->solve_y_omp();
+#pragma omp barrier
+		this->solve_z_omp();
+	}
+
+public:
+	void solve_iterations(std::size_t iterations) override { this->solve_steps(iterations); }
+};
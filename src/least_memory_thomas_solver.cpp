@@ -1,20 +1,26 @@
 #include "least_memory_thomas_solver.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <fstream>
 #include <iostream>
 #include <omp.h>
+#include <stdexcept>
+#include <type_traits>
 
+#include "partitioned_thomas_kernels.h"
 #include "solver_utils.h"
+#include "transpose_simd.h"
 
-template <typename real_t>
-void least_memory_thomas_solver<real_t>::precompute_values(std::unique_ptr<real_t[]>& a, std::unique_ptr<real_t[]>& b0,
-														   std::unique_ptr<index_t[]>& threshold_index, index_t shape,
-														   index_t dims, index_t n)
+template <typename real_t, typename index_t>
+void least_memory_thomas_solver<real_t, index_t>::precompute_values(aligned_buffer<real_t>& a,
+																	aligned_buffer<real_t>& b0,
+																	aligned_buffer<index_t>& threshold_index,
+																	index_t shape, index_t dims, index_t n)
 {
-	a = std::make_unique<real_t[]>(problem_.substrates_count);
-	b0 = std::make_unique<real_t[]>(problem_.substrates_count);
-	threshold_index = std::make_unique<index_t[]>(problem_.substrates_count);
+	a = allocator_.allocate<real_t>(problem_.substrates_count);
+	b0 = allocator_.allocate<real_t>(problem_.substrates_count);
+	threshold_index = allocator_.allocate<index_t>(problem_.substrates_count);
 
 	// compute a_i, b0_i
 	for (index_t s = 0; s < problem_.substrates_count; s++)
@@ -58,27 +64,65 @@ void least_memory_thomas_solver<real_t>::precompute_values(std::unique_ptr<real_
 	}
 }
 
-template <typename real_t>
-void least_memory_thomas_solver<real_t>::prepare(const max_problem_t& problem)
+template <typename real_t, typename index_t>
+std::size_t least_memory_thomas_solver<real_t, index_t>::allocated_elements(const max_problem_t& problem) const
 {
-	problem_ = problems::cast<std::int32_t, real_t>(problem);
-	substrates_ = std::make_unique<real_t[]>(problem_.nx * problem_.ny * problem_.nz * problem_.substrates_count);
+	auto [pad_x, pad_y] = padding_.get(problem.dims, problem.nx, problem.ny, sizeof(real_t));
+
+	return problem.substrates_count * (problem.nx + pad_x) * (problem.ny + pad_y) * problem.nz;
+}
+
+template <typename real_t, typename index_t>
+void least_memory_thomas_solver<real_t, index_t>::prepare(const max_problem_t& problem)
+{
+	problem_ = problems::cast<index_t, real_t>(problem);
+
+	auto [pad_x, pad_y] = padding_.get(problem_.dims, problem_.nx, problem_.ny, sizeof(real_t));
+
+	pad_x_ = pad_x;
+	pad_y_ = pad_y;
+	substrates_ = allocator_.allocate<real_t>(get_substrates_size());
 
 	// Initialize substrates
 
 	auto substrates_layout = get_substrates_layout<3>(problem_);
 
+	// the sweeps distribute (substrate, z slab) pairs - (substrate, y line) pairs in 2D - among the threads
+	if (problem_.dims == 3)
+		solver_utils::first_touch<'w'>(substrates_layout ^ noarr::merge_blocks<'s', 'z', 'w'>(), substrates_.get(),
+									   work_items_);
+	else
+		solver_utils::first_touch<'w'>(substrates_layout ^ noarr::fix<'z'>(0) ^ noarr::merge_blocks<'s', 'y', 'w'>(),
+									   substrates_.get(), work_items_);
+
 	solver_utils::initialize_substrate(substrates_layout, substrates_.get(), problem_);
 }
 
-template <typename real_t>
-void least_memory_thomas_solver<real_t>::tune(const nlohmann::json& params)
+template <typename real_t, typename index_t>
+void least_memory_thomas_solver<real_t, index_t>::tune(const nlohmann::json& params)
 {
+	allocator_.tune(params);
+	padding_.tune(params);
+
 	work_items_ = params.contains("work_items") ? (std::size_t)params["work_items"] : 1;
+
+	partitioned_x_ = params.contains("partitioned_x") ? (bool)params["partitioned_x"] : false;
+	partitioned_y_ = params.contains("partitioned_y") ? (bool)params["partitioned_y"] : false;
+	partitioned_z_ = params.contains("partitioned_z") ? (bool)params["partitioned_z"] : false;
+
+	vectorized_x_ = params.contains("vectorized_x") ? (bool)params["vectorized_x"] : false;
+
+	// the transposes are selected at the compile time, so they are missing in builds without AVX2 and in the
+	// DIFFUSE_ISA_DISPATCH builds, whose baseline is x86-64-v2 (see isa_dispatch.h)
+	if (vectorized_x_ && !transpose_simd<real_t>::available)
+		throw std::runtime_error("vectorized_x requires a build targeting AVX2 or AVX-512 (not DIFFUSE_ISA_DISPATCH)");
+
+	persistent_region_ = params.contains("persistent_region") ? (bool)params["persistent_region"] : false;
+	specialized_ = params.contains("specialized_kernels") ? (bool)params["specialized_kernels"] : true;
 }
 
-template <typename real_t>
-void least_memory_thomas_solver<real_t>::initialize()
+template <typename real_t, typename index_t>
+void least_memory_thomas_solver<real_t, index_t>::initialize()
 {
 	if (problem_.dims >= 1)
 		precompute_values(ax_, b0x_, threshold_indexx_, problem_.dx, problem_.dims, problem_.nx);
@@ -86,20 +130,46 @@ void least_memory_thomas_solver<real_t>::initialize()
 		precompute_values(ay_, b0y_, threshold_indexy_, problem_.dy, problem_.dims, problem_.ny);
 	if (problem_.dims >= 3)
 		precompute_values(az_, b0z_, threshold_indexz_, problem_.dz, problem_.dims, problem_.nz);
+
+	// each chunk of a partitioned line needs at least 3 rows
+	partitioned_x_ = partitioned_x_ && problem_.nx >= 3;
+	partitioned_y_ = partitioned_y_ && problem_.ny >= 3;
+	partitioned_z_ = partitioned_z_ && problem_.nz >= 3;
+
+	if (problem_.dims >= 1 && partitioned_x_)
+		precompute_partitioned_values(partitionedx_, allocator_, ax_.get(), b0x_.get(), problem_.nx,
+									  problem_.substrates_count);
+	if (problem_.dims >= 2 && partitioned_y_)
+		precompute_partitioned_values(partitionedy_, allocator_, ay_.get(), b0y_.get(), problem_.ny,
+									  problem_.substrates_count);
+	if (problem_.dims >= 3 && partitioned_z_)
+		precompute_partitioned_values(partitionedz_, allocator_, az_.get(), b0z_.get(), problem_.nz,
+									  problem_.substrates_count);
 }
 
-template <typename real_t>
-template <std::size_t dims>
-auto least_memory_thomas_solver<real_t>::get_substrates_layout(const problem_t<index_t, real_t>& problem)
+template <typename real_t, typename index_t>
+template <std::size_t dims, typename substrates_count_t>
+auto least_memory_thomas_solver<real_t, index_t>::get_substrates_layout(const problem_t<index_t, real_t>& problem,
+																		substrates_count_t substrates_count) const
 {
 	if constexpr (dims == 1)
-		return noarr::scalar<real_t>() ^ noarr::vectors<'x', 's'>(problem.nx, problem.substrates_count);
+		return noarr::scalar<real_t>() ^ noarr::vectors<'x', 's'>(problem.nx, substrates_count);
 	else if constexpr (dims == 2)
 		return noarr::scalar<real_t>()
-			   ^ noarr::vectors<'x', 'y', 's'>(problem.nx, problem.ny, problem.substrates_count);
+			   ^ noarr::vectors<'x', 'y', 's'>(problem.nx + pad_x_, problem.ny, substrates_count)
+			   ^ noarr::slice<'x'>(0, problem.nx);
 	else if constexpr (dims == 3)
 		return noarr::scalar<real_t>()
-			   ^ noarr::vectors<'x', 'y', 'z', 's'>(problem.nx, problem.ny, problem.nz, problem.substrates_count);
+			   ^ noarr::vectors<'x', 'y', 'z', 's'>(problem.nx + pad_x_, problem.ny + pad_y_, problem.nz,
+													substrates_count)
+			   ^ noarr::slice<'x'>(0, problem.nx) ^ noarr::slice<'y'>(0, problem.ny);
+}
+
+template <typename real_t, typename index_t>
+template <std::size_t dims>
+auto least_memory_thomas_solver<real_t, index_t>::get_substrates_layout(const problem_t<index_t, real_t>& problem) const
+{
+	return get_substrates_layout<dims>(problem, problem.substrates_count);
 }
 
 template <typename index_t, typename real_t, typename density_layout_t>
@@ -179,13 +249,69 @@ void solve_slice_x_1d(real_t* __restrict__ densities, const real_t* __restrict__
 	}
 }
 
+template <typename index_t, typename real_t, typename density_layout_t>
+void solve_line_x(real_t* __restrict__ densities, const real_t* __restrict__ a, const real_t* __restrict__ b0,
+				  const index_t* __restrict__ threshold, const density_layout_t dens_l, index_t s, index_t yz)
+{
+	const index_t n = dens_l | noarr::get_length<'x'>();
+
+	real_t b_tmp = b0[s];
+
+	{
+		(dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, 1, s)) -=
+			a[s] * (dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, 0, s)) / b_tmp;
+	}
+
+	for (index_t i = 2; i < threshold[s]; i++)
+	{
+		b_tmp = (b0[s] - a[s]) - (a[s] * a[s]) / b_tmp;
+
+		(dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i, s)) -=
+			a[s] * (dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i - 1, s)) / b_tmp;
+	}
+
+	for (index_t i = threshold[s]; i < n; i++)
+	{
+		(dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i, s)) -=
+			a[s] * (dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i - 1, s)) / b_tmp;
+	}
+
+	{
+		(dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, n - 1, s)) /= b0[s] - (a[s] * a[s]) / b_tmp;
+	}
+
+	{
+		(dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, n - 2, s)) =
+			((dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, n - 2, s))
+			 - a[s] * (dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, n - 1, s)))
+			/ b_tmp;
+	}
+
+	for (index_t i = n - 3; i >= threshold[s] - 1; i--)
+	{
+		(dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i, s)) =
+			((dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i, s))
+			 - a[s] * (dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i + 1, s)))
+			/ b_tmp;
+	}
+
+	for (index_t i = threshold[s] - 2; i >= 0; i--)
+	{
+		(dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i, s)) =
+			((dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i, s))
+			 - a[s] * (dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i + 1, s)))
+			/ b_tmp;
+
+		b_tmp = (a[s] * a[s]) / (b0[s] - a[s] - b_tmp);
+	}
+}
+
 template <typename index_t, typename real_t, typename density_layout_t>
 void solve_slice_x_2d_and_3d(real_t* __restrict__ densities, const real_t* __restrict__ a,
 							 const real_t* __restrict__ b0, const index_t* __restrict__ threshold,
 							 const density_layout_t dens_l, std::size_t work_items)
 {
 	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
-	const index_t n = dens_l | noarr::get_length<'x'>();
 	const index_t m = dens_l | noarr::get_length<'m'>();
 
 #pragma omp for schedule(static, work_items) collapse(2) nowait
@@ -193,59 +319,200 @@ void solve_slice_x_2d_and_3d(real_t* __restrict__ densities, const real_t* __res
 	{
 		for (index_t yz = 0; yz < m; yz++)
 		{
+			solve_line_x<index_t>(densities, a, b0, threshold, dens_l, s, yz);
+		}
+	}
+}
+
+// Solves groups of neighbouring x lines at once; the lines of a group are transposed in registers, so each SIMD lane
+// runs the recurrence of one line. The groups are interleaved to hide the latency of the dependent FMAs.
+template <typename index_t, typename real_t, typename density_layout_t>
+void solve_slice_x_2d_and_3d_transpose(real_t* __restrict__ densities, const real_t* __restrict__ a,
+									   const real_t* __restrict__ b0, const index_t* __restrict__ threshold,
+									   const density_layout_t dens_l, std::size_t work_items)
+{
+	using simd_t = transpose_simd<real_t>;
+	using vec_t = typename simd_t::vec_t;
+
+	constexpr index_t width = simd_t::width;
+	constexpr index_t groups = 2;
+	constexpr index_t block_lines = width * groups;
+
+	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+	const index_t n = dens_l | noarr::get_length<'x'>();
+	const index_t m = dens_l | noarr::get_length<'m'>();
+
+	const index_t blocks = (m + block_lines - 1) / block_lines;
+
+#pragma omp for schedule(static, work_items) collapse(2) nowait
+	for (index_t s = 0; s < substrates_count; s++)
+	{
+		for (index_t block = 0; block < blocks; block++)
+		{
+			const index_t yz_begin = block * block_lines;
+			const index_t lines = std::min(block_lines, m - yz_begin);
+			const bool vectorized = lines == block_lines;
+
+			auto d = [&](index_t line, index_t i) -> real_t& {
+				return dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz_begin + line, i, s);
+			};
+
+			// b_tmp of the forward substitution, generated in the order of rows
 			real_t b_tmp = b0[s];
+			auto forward_factor = [&](index_t i) -> real_t {
+				if (i == 0)
+					return 0;
+				if (i >= 2 && i < threshold[s])
+					b_tmp = (b0[s] - a[s]) - (a[s] * a[s]) / b_tmp;
+				return a[s] / b_tmp;
+			};
 
-			{
-				(dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, 1, s)) -=
-					a[s] * (dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, 0, s)) / b_tmp;
-			}
+			real_t factors[width];
+			vec_t rows[groups][width];
 
-			for (index_t i = 2; i < threshold[s]; i++)
+			// forward substitution
 			{
-				b_tmp = (b0[s] - a[s]) - (a[s] * a[s]) / b_tmp;
+				vec_t prev[groups];
+				for (index_t g = 0; g < groups; g++)
+					prev[g] = simd_t::zero();
 
-				(dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i, s)) -=
-					a[s] * (dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i - 1, s)) / b_tmp;
+				for (index_t x = 0; x < n; x += width)
+				{
+					const index_t len = std::min(width, n - x);
+
+					for (index_t k = 0; k < len; k++)
+						factors[k] = forward_factor(x + k);
+
+					if (!vectorized || len != width)
+					{
+						for (index_t k = 0; k < len; k++)
+							if (x + k > 0)
+								for (index_t l = 0; l < lines; l++)
+									d(l, x + k) -= factors[k] * d(l, x + k - 1);
+						continue;
+					}
+
+					for (index_t g = 0; g < groups; g++)
+					{
+						for (index_t l = 0; l < width; l++)
+							rows[g][l] = simd_t::load(&d(g * width + l, x));
+						transpose_block<simd_t>(rows[g]);
+					}
+
+					for (index_t k = 0; k < width; k++)
+					{
+						const vec_t factor = simd_t::set1(factors[k]);
+						for (index_t g = 0; g < groups; g++)
+							rows[g][k] = simd_t::fnmadd(factor, k == 0 ? prev[g] : rows[g][k - 1], rows[g][k]);
+					}
+
+					for (index_t g = 0; g < groups; g++)
+					{
+						prev[g] = rows[g][width - 1];
+						transpose_block<simd_t>(rows[g]);
+						for (index_t l = 0; l < width; l++)
+							simd_t::store(&d(g * width + l, x), rows[g][l]);
+					}
+				}
 			}
 
-			for (index_t i = threshold[s]; i < n; i++)
-			{
-				(dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i, s)) -=
-					a[s] * (dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i - 1, s)) / b_tmp;
-			}
+			// b_tmp of the backward substitution, generated in the reverse order of rows
+			auto backward_factor = [&](index_t i) -> real_t {
+				if (i == n - 1)
+					return 1 / (b0[s] - (a[s] * a[s]) / b_tmp);
+				if (i + 2 < n && i + 2 < threshold[s])
+					b_tmp = (a[s] * a[s]) / (b0[s] - a[s] - b_tmp);
+				return 1 / b_tmp;
+			};
 
+			// backward substitution
 			{
-				(dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, n - 1, s)) /= b0[s] - (a[s] * a[s]) / b_tmp;
-			}
+				const index_t vectorized_n = n / width * width;
 
-			{
-				(dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, n - 2, s)) =
-					((dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, n - 2, s))
-					 - a[s] * (dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, n - 1, s)))
-					/ b_tmp;
-			}
+				for (index_t i = n - 1; i >= vectorized_n; i--)
+				{
+					const real_t factor = backward_factor(i);
+					for (index_t l = 0; l < lines; l++)
+						d(l, i) = (d(l, i) - (i == n - 1 ? 0 : a[s] * d(l, i + 1))) * factor;
+				}
 
-			for (index_t i = n - 3; i >= threshold[s] - 1; i--)
-			{
-				(dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i, s)) =
-					((dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i, s))
-					 - a[s] * (dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i + 1, s)))
-					/ b_tmp;
-			}
+				vec_t next[groups];
+				for (index_t g = 0; g < groups; g++)
+					next[g] = simd_t::zero();
 
-			for (index_t i = threshold[s] - 2; i >= 0; i--)
-			{
-				(dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i, s)) =
-					((dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i, s))
-					 - a[s] * (dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i + 1, s)))
-					/ b_tmp;
+				if (vectorized && vectorized_n != n)
+				{
+					for (index_t g = 0; g < groups; g++)
+					{
+						real_t tmp[width];
+						for (index_t l = 0; l < width; l++)
+							tmp[l] = d(g * width + l, vectorized_n);
+						next[g] = simd_t::load(tmp);
+					}
+				}
 
-				b_tmp = (a[s] * a[s]) / (b0[s] - a[s] - b_tmp);
+				const vec_t a_vec = simd_t::set1(a[s]);
+
+				for (index_t x = vectorized_n - width; x >= 0; x -= width)
+				{
+					for (index_t k = width - 1; k >= 0; k--)
+						factors[k] = backward_factor(x + k);
+
+					if (!vectorized)
+					{
+						for (index_t k = width - 1; k >= 0; k--)
+							for (index_t l = 0; l < lines; l++)
+								d(l, x + k) =
+									(d(l, x + k) - (x + k == n - 1 ? 0 : a[s] * d(l, x + k + 1))) * factors[k];
+						continue;
+					}
+
+					for (index_t g = 0; g < groups; g++)
+					{
+						for (index_t l = 0; l < width; l++)
+							rows[g][l] = simd_t::load(&d(g * width + l, x));
+						transpose_block<simd_t>(rows[g]);
+					}
+
+					for (index_t k = width - 1; k >= 0; k--)
+					{
+						const vec_t factor = simd_t::set1(factors[k]);
+						for (index_t g = 0; g < groups; g++)
+							rows[g][k] = simd_t::mul(
+								simd_t::fnmadd(a_vec, k == width - 1 ? next[g] : rows[g][k + 1], rows[g][k]), factor);
+					}
+
+					for (index_t g = 0; g < groups; g++)
+					{
+						next[g] = rows[g][0];
+						transpose_block<simd_t>(rows[g]);
+						for (index_t l = 0; l < width; l++)
+							simd_t::store(&d(g * width + l, x), rows[g][l]);
+					}
+				}
 			}
 		}
 	}
 }
 
+// Uses the transposed kernel if it was requested and the instruction set supports it
+template <typename index_t, typename real_t, typename density_layout_t>
+void solve_slice_x_2d_and_3d_dispatch(real_t* __restrict__ densities, const real_t* __restrict__ a,
+									  const real_t* __restrict__ b0, const index_t* __restrict__ threshold,
+									  const density_layout_t dens_l, std::size_t work_items, bool vectorized)
+{
+	if constexpr (transpose_simd<real_t>::available)
+	{
+		if (vectorized)
+		{
+			solve_slice_x_2d_and_3d_transpose<index_t>(densities, a, b0, threshold, dens_l, work_items);
+			return;
+		}
+	}
+
+	solve_slice_x_2d_and_3d<index_t>(densities, a, b0, threshold, dens_l, work_items);
+}
+
 template <typename index_t, typename real_t, typename density_layout_t>
 void solve_slice_y_2d(real_t* __restrict__ densities, const real_t* __restrict__ a, const real_t* __restrict__ b0,
 					  const index_t* __restrict__ threshold, const density_layout_t dens_l, std::size_t work_items)
@@ -328,87 +595,121 @@ void solve_slice_y_2d(real_t* __restrict__ densities, const real_t* __restrict__
 }
 
 template <typename index_t, typename real_t, typename density_layout_t>
-void solve_slice_y_3d(real_t* __restrict__ densities, const real_t* __restrict__ a, const real_t* __restrict__ b0,
-					  const index_t* __restrict__ threshold, const density_layout_t dens_l, std::size_t work_items)
+void solve_slab_y(real_t* __restrict__ densities, const real_t* __restrict__ a, const real_t* __restrict__ b0,
+				  const index_t* __restrict__ threshold, const density_layout_t dens_l, index_t s, index_t z)
 {
-	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
 	const index_t n = dens_l | noarr::get_length<'y'>();
-	const index_t z_len = dens_l | noarr::get_length<'z'>();
 	const index_t x_len = dens_l | noarr::get_length<'x'>();
 
-#pragma omp for schedule(static, work_items) collapse(2) nowait
-	for (index_t s = 0; s < substrates_count; s++)
-	{
-		for (index_t z = 0; z < z_len; z++)
-		{
-			real_t b_tmp = b0[s];
+	real_t b_tmp = b0[s];
 
 #pragma omp simd
-			for (index_t x = 0; x < x_len; x++)
-			{
-				(dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, 1, s)) -=
-					a[s] * (dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, 0, s)) / b_tmp;
-			}
+	for (index_t x = 0; x < x_len; x++)
+	{
+		(dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, 1, s)) -=
+			a[s] * (dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, 0, s)) / b_tmp;
+	}
 
-			for (index_t i = 2; i < threshold[s]; i++)
-			{
-				b_tmp = (b0[s] - a[s]) - (a[s] * a[s]) / b_tmp;
+	for (index_t i = 2; i < threshold[s]; i++)
+	{
+		b_tmp = (b0[s] - a[s]) - (a[s] * a[s]) / b_tmp;
 
 #pragma omp simd
-				for (index_t x = 0; x < x_len; x++)
-				{
-					(dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, i, s)) -=
-						a[s] * (dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, i - 1, s)) / b_tmp;
-				}
-			}
+		for (index_t x = 0; x < x_len; x++)
+		{
+			(dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, i, s)) -=
+				a[s] * (dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, i - 1, s)) / b_tmp;
+		}
+	}
 
-			for (index_t i = threshold[s]; i < n; i++)
-			{
+	for (index_t i = threshold[s]; i < n; i++)
+	{
 #pragma omp simd
-				for (index_t x = 0; x < x_len; x++)
-				{
-					(dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, i, s)) -=
-						a[s] * (dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, i - 1, s)) / b_tmp;
-				}
-			}
+		for (index_t x = 0; x < x_len; x++)
+		{
+			(dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, i, s)) -=
+				a[s] * (dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, i - 1, s)) / b_tmp;
+		}
+	}
 
 #pragma omp simd
-			for (index_t x = 0; x < x_len; x++)
-			{
-				(dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, n - 1, s)) /=
-					b0[s] - (a[s] * a[s]) / b_tmp;
+	for (index_t x = 0; x < x_len; x++)
+	{
+		(dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, n - 1, s)) /=
+			b0[s] - (a[s] * a[s]) / b_tmp;
 
-				(dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, n - 2, s)) =
-					((dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, n - 2, s))
-					 - a[s] * (dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, n - 1, s)))
-					/ b_tmp;
-			}
+		(dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, n - 2, s)) =
+			((dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, n - 2, s))
+			 - a[s] * (dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, n - 1, s)))
+			/ b_tmp;
+	}
 
-			for (index_t i = n - 3; i >= threshold[s] - 1; i--)
-			{
+	for (index_t i = n - 3; i >= threshold[s] - 1; i--)
+	{
 #pragma omp simd
-				for (index_t x = 0; x < x_len; x++)
-				{
-					(dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, i, s)) =
-						((dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, i, s))
-						 - a[s] * (dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, i + 1, s)))
-						/ b_tmp;
-				}
-			}
+		for (index_t x = 0; x < x_len; x++)
+		{
+			(dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, i, s)) =
+				((dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, i, s))
+				 - a[s] * (dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, i + 1, s)))
+				/ b_tmp;
+		}
+	}
 
-			for (index_t i = threshold[s] - 2; i >= 0; i--)
-			{
+	for (index_t i = threshold[s] - 2; i >= 0; i--)
+	{
 #pragma omp simd
-				for (index_t x = 0; x < x_len; x++)
-				{
-					(dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, i, s)) =
-						((dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, i, s))
-						 - a[s] * (dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, i + 1, s)))
-						/ b_tmp;
-				}
+		for (index_t x = 0; x < x_len; x++)
+		{
+			(dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, i, s)) =
+				((dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, i, s))
+				 - a[s] * (dens_l | noarr::get_at<'z', 'x', 'y', 's'>(densities, z, x, i + 1, s)))
+				/ b_tmp;
+		}
 
-				b_tmp = (a[s] * a[s]) / (b0[s] - a[s] - b_tmp);
-			}
+		b_tmp = (a[s] * a[s]) / (b0[s] - a[s] - b_tmp);
+	}
+}
+
+template <typename index_t, typename real_t, typename density_layout_t>
+void solve_slice_y_3d(real_t* __restrict__ densities, const real_t* __restrict__ a, const real_t* __restrict__ b0,
+					  const index_t* __restrict__ threshold, const density_layout_t dens_l, std::size_t work_items)
+{
+	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+	const index_t z_len = dens_l | noarr::get_length<'z'>();
+
+#pragma omp for schedule(static, work_items) collapse(2) nowait
+	for (index_t s = 0; s < substrates_count; s++)
+	{
+		for (index_t z = 0; z < z_len; z++)
+		{
+			solve_slab_y<index_t>(densities, a, b0, threshold, dens_l, s, z);
+		}
+	}
+}
+
+// Solves x and y sweeps of one z slab after another, so the y sweep finds the slab still in the cache
+template <typename index_t, typename real_t, typename density_layout_t>
+void solve_slice_xy_3d(real_t* __restrict__ densities, const real_t* __restrict__ ax, const real_t* __restrict__ b0x,
+					   const index_t* __restrict__ thresholdx, const real_t* __restrict__ ay,
+					   const real_t* __restrict__ b0y, const index_t* __restrict__ thresholdy,
+					   const density_layout_t dens_l, std::size_t work_items)
+{
+	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+	const index_t z_len = dens_l | noarr::get_length<'z'>();
+	const index_t y_len = dens_l | noarr::get_length<'y'>();
+
+	auto x_dens_l = dens_l ^ noarr::merge_blocks<'z', 'y', 'm'>();
+
+#pragma omp for schedule(static, work_items) collapse(2)
+	for (index_t s = 0; s < substrates_count; s++)
+	{
+		for (index_t z = 0; z < z_len; z++)
+		{
+			for (index_t y = 0; y < y_len; y++)
+				solve_line_x<index_t>(densities, ax, b0x, thresholdx, x_dens_l, s, z * y_len + y);
+
+			solve_slab_y<index_t>(densities, ay, b0y, thresholdy, dens_l, s, z);
 		}
 	}
 }
@@ -514,57 +815,182 @@ void solve_slice_z_3d(real_t* __restrict__ densities, const real_t* __restrict__
 	}
 }
 
-template <typename real_t>
-void least_memory_thomas_solver<real_t>::solve_x()
+template <typename real_t, typename index_t>
+void least_memory_thomas_solver<real_t, index_t>::solve_x()
 {
-	if (problem_.dims == 1)
-	{
 #pragma omp parallel
-		solve_slice_x_1d<index_t>(substrates_.get(), ax_.get(), b0x_.get(), threshold_indexx_.get(),
-								  get_substrates_layout<1>(problem_), work_items_);
-	}
-	else if (problem_.dims == 2)
-	{
+	solve_x_omp();
+}
+
+template <typename real_t, typename index_t>
+void least_memory_thomas_solver<real_t, index_t>::solve_x_omp()
+{
+	solver_utils::dispatch_substrates_count(problem_.substrates_count, specialized_, [&](auto substrates_count) {
+		if (partitioned_x_)
+		{
+			if (problem_.dims == 1)
+			{
+				solve_slice_partitioned<index_t>(substrates_.get(), ax_.get(), partitionedx_,
+												 get_substrates_layout<1>(problem_, substrates_count)
+													 ^ noarr::rename<'x', 'i'>() ^ noarr::vector<'q'>(1)
+													 ^ noarr::vector<'m'>(1));
+			}
+			else if (problem_.dims == 2)
+			{
+				solve_slice_partitioned<index_t>(substrates_.get(), ax_.get(), partitionedx_,
+												 get_substrates_layout<2>(problem_, substrates_count)
+													 ^ noarr::rename<'x', 'i', 'y', 'm'>() ^ noarr::vector<'q'>(1));
+			}
+			else if (problem_.dims == 3)
+			{
+				solve_slice_partitioned<index_t>(substrates_.get(), ax_.get(), partitionedx_,
+												 get_substrates_layout<3>(problem_, substrates_count)
+													 ^ noarr::rename<'x', 'i'>() ^ noarr::merge_blocks<'z', 'y', 'm'>()
+													 ^ noarr::vector<'q'>(1));
+			}
+		}
+		else if (problem_.dims == 1)
+		{
+			solve_slice_x_1d<index_t>(substrates_.get(), ax_.get(), b0x_.get(), threshold_indexx_.get(),
+									  get_substrates_layout<1>(problem_, substrates_count), work_items_);
+		}
+		else if (problem_.dims == 2)
+		{
+			solve_slice_x_2d_and_3d_dispatch<index_t>(substrates_.get(), ax_.get(), b0x_.get(),
+													  threshold_indexx_.get(),
+													  get_substrates_layout<2>(problem_, substrates_count)
+														  ^ noarr::rename<'y', 'm'>(),
+													  work_items_, vectorized_x_);
+		}
+		else if (problem_.dims == 3)
+		{
+			solve_slice_x_2d_and_3d_dispatch<index_t>(substrates_.get(), ax_.get(), b0x_.get(),
+													  threshold_indexx_.get(),
+													  get_substrates_layout<3>(problem_, substrates_count)
+														  ^ noarr::merge_blocks<'z', 'y', 'm'>(),
+													  work_items_, vectorized_x_);
+		}
+	});
+}
+
+template <typename real_t, typename index_t>
+void least_memory_thomas_solver<real_t, index_t>::solve_y()
+{
 #pragma omp parallel
-		solve_slice_x_2d_and_3d<index_t>(substrates_.get(), ax_.get(), b0x_.get(), threshold_indexx_.get(),
-										 get_substrates_layout<2>(problem_) ^ noarr::rename<'y', 'm'>(), work_items_);
-	}
-	else if (problem_.dims == 3)
-	{
+	solve_y_omp();
+}
+
+template <typename real_t, typename index_t>
+void least_memory_thomas_solver<real_t, index_t>::solve_y_omp()
+{
+	solver_utils::dispatch_substrates_count(problem_.substrates_count, specialized_, [&](auto substrates_count) {
+		if (partitioned_y_)
+		{
+			if (problem_.dims == 2)
+			{
+				solve_slice_partitioned<index_t>(substrates_.get(), ay_.get(), partitionedy_,
+												 get_substrates_layout<2>(problem_, substrates_count)
+													 ^ noarr::rename<'x', 'q', 'y', 'i'>() ^ noarr::vector<'m'>(1));
+			}
+			else if (problem_.dims == 3)
+			{
+				solve_slice_partitioned<index_t>(substrates_.get(), ay_.get(), partitionedy_,
+												 get_substrates_layout<3>(problem_, substrates_count)
+													 ^ noarr::rename<'x', 'q', 'y', 'i', 'z', 'm'>());
+			}
+		}
+		else if (problem_.dims == 2)
+		{
+			solve_slice_y_2d<index_t>(substrates_.get(), ay_.get(), b0y_.get(), threshold_indexy_.get(),
+									  get_substrates_layout<2>(problem_, substrates_count), work_items_);
+		}
+		else if (problem_.dims == 3)
+		{
+			solve_slice_y_3d<index_t>(substrates_.get(), ay_.get(), b0y_.get(), threshold_indexy_.get(),
+									  get_substrates_layout<3>(problem_, substrates_count), work_items_);
+		}
+	});
+}
+
+template <typename real_t, typename index_t>
+void least_memory_thomas_solver<real_t, index_t>::solve_z()
+{
 #pragma omp parallel
-		solve_slice_x_2d_and_3d<index_t>(substrates_.get(), ax_.get(), b0x_.get(), threshold_indexx_.get(),
-										 get_substrates_layout<3>(problem_) ^ noarr::merge_blocks<'z', 'y', 'm'>(),
-										 work_items_);
-	}
+	solve_z_omp();
+}
+
+template <typename real_t, typename index_t>
+void least_memory_thomas_solver<real_t, index_t>::solve_z_omp()
+{
+	if (problem_.dims != 3)
+		return;
+
+	solver_utils::dispatch_substrates_count(problem_.substrates_count, specialized_, [&](auto substrates_count) {
+		if (partitioned_z_)
+		{
+			solve_slice_partitioned<index_t>(substrates_.get(), az_.get(), partitionedz_,
+											 get_substrates_layout<3>(problem_, substrates_count)
+												 ^ noarr::rename<'z', 'i'>() ^ noarr::merge_blocks<'y', 'x', 'q'>()
+												 ^ noarr::vector<'m'>(1));
+		}
+		else
+		{
+			solve_slice_z_3d<index_t>(substrates_.get(), az_.get(), b0z_.get(), threshold_indexz_.get(),
+									  get_substrates_layout<3>(problem_, substrates_count), work_items_);
+		}
+	});
 }
 
-template <typename real_t>
-void least_memory_thomas_solver<real_t>::solve_y()
+template <typename real_t, typename index_t>
+void least_memory_thomas_solver<real_t, index_t>::solve_omp()
 {
-	if (problem_.dims == 2)
+	// the fusion uses only the basic line kernels
+	if (problem_.dims == 3 && !partitioned_x_ && !partitioned_y_ && !vectorized_x_)
 	{
-#pragma omp parallel
-		solve_slice_y_2d<index_t>(substrates_.get(), ay_.get(), b0y_.get(), threshold_indexy_.get(),
-								  get_substrates_layout<2>(problem_), work_items_);
+		solver_utils::dispatch_substrates_count(problem_.substrates_count, specialized_, [&](auto substrates_count) {
+			solve_slice_xy_3d<index_t>(substrates_.get(), ax_.get(), b0x_.get(), threshold_indexx_.get(), ay_.get(),
+									   b0y_.get(), threshold_indexy_.get(),
+									   get_substrates_layout<3>(problem_, substrates_count), work_items_);
+		});
+		solve_z_omp();
 	}
-	else if (problem_.dims == 3)
+	else
 	{
-#pragma omp parallel
-		solve_slice_y_3d<index_t>(substrates_.get(), ay_.get(), b0y_.get(), threshold_indexy_.get(),
-								  get_substrates_layout<3>(problem_), work_items_);
+		solve_x_omp();
+#pragma omp barrier
+		solve_y_omp();
+#pragma omp barrier
+		solve_z_omp();
 	}
 }
 
-template <typename real_t>
-void least_memory_thomas_solver<real_t>::solve_z()
+template <typename real_t, typename index_t>
+void least_memory_thomas_solver<real_t, index_t>::solve()
+{
+#pragma omp parallel
+	solve_omp();
+}
+
+template <typename real_t, typename index_t>
+void least_memory_thomas_solver<real_t, index_t>::solve_iterations(std::size_t iterations)
 {
+	if (persistent_region_)
+	{
 #pragma omp parallel
-	solve_slice_z_3d<index_t>(substrates_.get(), az_.get(), b0z_.get(), threshold_indexz_.get(),
-							  get_substrates_layout<3>(problem_), work_items_);
+		for (std::size_t i = 0; i < iterations; i++)
+		{
+			solve_omp();
+#pragma omp barrier
+		}
+	}
+	else
+	{
+		tridiagonal_solver::solve_iterations(iterations);
+	}
 }
 
-template <typename real_t>
-void least_memory_thomas_solver<real_t>::save(const std::string& file) const
+template <typename real_t, typename index_t>
+void least_memory_thomas_solver<real_t, index_t>::save(const std::string& file) const
 {
 	auto dens_l = get_substrates_layout<3>(problem_);
 
@@ -582,19 +1008,25 @@ void least_memory_thomas_solver<real_t>::save(const std::string& file) const
 	out.close();
 }
 
-template <typename real_t>
-double least_memory_thomas_solver<real_t>::access(std::size_t s, std::size_t x, std::size_t y, std::size_t z) const
+template <typename real_t, typename index_t>
+std::span<const std::byte> least_memory_thomas_solver<real_t, index_t>::substrates_memory() const
+{
+	return std::as_bytes(std::span(substrates_.get(), get_substrates_size()));
+}
+
+template <typename real_t, typename index_t>
+double least_memory_thomas_solver<real_t, index_t>::access(std::size_t s, std::size_t x, std::size_t y,
+														   std::size_t z) const
 {
 	auto dens_l = get_substrates_layout<3>(problem_);
 
 	return (dens_l | noarr::get_at<'s', 'x', 'y', 'z'>(substrates_.get(), s, x, y, z));
 }
 
-template <>
-float least_memory_thomas_solver<float>::limit_threshold_ = 1e-6f;
-
-template <>
-double least_memory_thomas_solver<double>::limit_threshold_ = 1e-12;
+template <typename real_t, typename index_t>
+real_t least_memory_thomas_solver<real_t, index_t>::limit_threshold_ = std::is_same_v<real_t, float> ? 1e-6f : 1e-12;
 
-template class least_memory_thomas_solver<float>;
-template class least_memory_thomas_solver<double>;
+template class least_memory_thomas_solver<float, std::int32_t>;
+template class least_memory_thomas_solver<float, std::int64_t>;
+template class least_memory_thomas_solver<double, std::int32_t>;
+template class least_memory_thomas_solver<double, std::int64_t>;
@@ -4,6 +4,9 @@
 
 #include <noarr/structures_extended.hpp>
 
+#include "aligned_allocator.h"
+#include "layout_padding.h"
+#include "partitioned_thomas_kernels.h"
 #include "tridiagonal_solver.h"
 
 /*
@@ -28,45 +31,103 @@ d_i'  == d_i - e_i*d_(i-1)                                    1 <  i <= n
 The backpropagation (2n multiplications + n subtractions):
 d_n'' == d_n'/b_n'
 d_i'' == (d_i' - c_i*d_(i+1)'')*b_i'                          n >  i >= 1
+
+Optionally, a dimension can be solved by the partitioned (SPIKE-like) variant, where each line is split into chunks
+that are processed by different threads. Within a chunk with rows f..l, the modified forward and backward substitutions
+eliminate all couplings except those to the first and the last row of the chunk (and to the neighbouring chunks):
+a_i'*d_f + d_i + c_i'*d_l == d_i'                             f <  i <  l
+The first and the last rows of all chunks form a reduced tridiagonal system of 2*chunks rows, which is solved by a
+single Thomas pass. Finally, the inner rows of each chunk are back-filled using the solved first and last rows.
+
+Since x is the innermost dimension, the x recurrence of a single line cannot be vectorized. Optionally, a block of
+neighbouring lines is loaded and transposed in SIMD registers (AVX2/AVX-512), so that each lane runs one line. This
+requires a build targeting AVX2 or AVX-512 (not DIFFUSE_ISA_DISPATCH), otherwise "vectorized_x" is rejected.
+
+A whole time step (solve) fuses the x and y sweeps: each z slab is solved in x and right after in y while it is
+still in the cache, so only the z sweep streams the grid separately.
+
+With the persistent region, multiple steps are solved in a single parallel region with barriers between the sweeps.
+
+The x lines and the xy planes of the densities can be padded to avoid the aliasing of power-of-two strides (see
+layout_padding).
 */
 
-template <typename real_t>
+template <typename real_t, typename index_t>
 class least_memory_thomas_solver : public tridiagonal_solver
 {
-	using index_t = std::int32_t;
-
 	problem_t<index_t, real_t> problem_;
 
-	std::unique_ptr<real_t[]> substrates_;
+	aligned_allocator allocator_;
+	layout_padding padding_;
+
+	// the x points appended to each x line and the x lines appended to each xy plane
+	index_t pad_x_ = 0, pad_y_ = 0;
+
+	aligned_buffer<real_t> substrates_;
 
-	std::unique_ptr<real_t[]> ax_, b0x_, scratchpadx_;
-	std::unique_ptr<real_t[]> ay_, b0y_, scratchpady_;
-	std::unique_ptr<real_t[]> az_, b0z_, scratchpadz_;
+	aligned_buffer<real_t> ax_, b0x_, scratchpadx_;
+	aligned_buffer<real_t> ay_, b0y_, scratchpady_;
+	aligned_buffer<real_t> az_, b0z_, scratchpadz_;
 
-	std::unique_ptr<index_t[]> threshold_indexx_, threshold_indexy_, threshold_indexz_;
+	aligned_buffer<index_t> threshold_indexx_, threshold_indexy_, threshold_indexz_;
+
+	partitioned_values_t<real_t, index_t> partitionedx_, partitionedy_, partitionedz_;
 
 	static real_t limit_threshold_;
 
 	std::size_t work_items_;
 
+	bool partitioned_x_, partitioned_y_, partitioned_z_;
+
+	bool vectorized_x_;
+
+	bool persistent_region_;
+
+	// whether the sweeps use the kernels specialized for the substrates count
+	bool specialized_;
+
+	// The padding is sliced away, so the layouts have the grid lengths; a 1D line and a 2D plane are not padded
+	std::size_t get_substrates_size() const
+	{
+		return (std::size_t)problem_.substrates_count * (problem_.nx + pad_x_) * (problem_.ny + pad_y_) * problem_.nz;
+	}
+
+	// The substrates count is either index_t or noarr::lit for the specialized kernels
+	template <std::size_t dims, typename substrates_count_t>
+	auto get_substrates_layout(const problem_t<index_t, real_t>& problem, substrates_count_t substrates_count) const;
+
 	template <std::size_t dims>
-	static auto get_substrates_layout(const problem_t<index_t, real_t>& problem);
+	auto get_substrates_layout(const problem_t<index_t, real_t>& problem) const;
 
-	void precompute_values(std::unique_ptr<real_t[]>& a, std::unique_ptr<real_t[]>& b0,
-						   std::unique_ptr<index_t[]>& threshold_index, index_t shape, index_t dims, index_t n);
+	void precompute_values(aligned_buffer<real_t>& a, aligned_buffer<real_t>& b0,
+						   aligned_buffer<index_t>& threshold_index, index_t shape, index_t dims, index_t n);
+
+	// The sweeps without their own parallel region, so they can be called from an enclosing one
+	void solve_x_omp();
+	void solve_y_omp();
+	void solve_z_omp();
+	void solve_omp();
 
 public:
 	void prepare(const max_problem_t& problem) override;
 
 	void tune(const nlohmann::json& params) override;
 
+	std::size_t allocated_elements(const max_problem_t& problem) const override;
+
 	void initialize() override;
 
 	void solve_x() override;
 	void solve_y() override;
 	void solve_z() override;
 
+	void solve() override;
+
+	void solve_iterations(std::size_t iterations) override;
+
 	void save(const std::string& file) const override;
 
+	std::span<const std::byte> substrates_memory() const override;
+
 	double access(std::size_t s, std::size_t x, std::size_t y, std::size_t z) const override;
 };
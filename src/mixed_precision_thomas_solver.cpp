@@ -0,0 +1,263 @@
+#include "mixed_precision_thomas_solver.h"
+
+#include <algorithm>
+#include <omp.h>
+
+#include "solver_utils.h"
+
+template <typename real_t, typename storage_t, typename index_t>
+void mixed_precision_thomas_solver<real_t, storage_t, index_t>::tune(const nlohmann::json& params)
+{
+	base_t::tune(params);
+
+	x_tile_size_ = params.contains("x_tile_size") ? (std::size_t)params["x_tile_size"] : 0;
+}
+
+template <typename real_t, typename storage_t, typename index_t>
+void mixed_precision_thomas_solver<real_t, storage_t, index_t>::prepare(const max_problem_t& problem)
+{
+	this->problem_ = problems::cast<index_t, real_t>(problem);
+
+	this->resolve_padding(sizeof(storage_t));
+	storage_ = this->allocator_.template allocate<storage_t>(this->get_substrates_size());
+
+	// Initialize substrates
+
+	auto storage_layout = get_storage_layout(this->problem_);
+
+	if (this->problem_.dims == 3)
+		solver_utils::first_touch<'z'>(storage_layout, storage_.get(), this->work_items_);
+	else
+		solver_utils::first_touch<'y'>(storage_layout, storage_.get(), this->work_items_);
+
+	solver_utils::initialize_substrate(storage_layout, storage_.get(), this->problem_);
+
+	// an x line or an x tile of a y slab (x, y) or a z slab (x, z) is solved at once, rounded up to cache lines so
+	// that the buffers of the threads do not share them
+	const std::size_t substrates_count = this->problem_.substrates_count;
+	const std::size_t slab_n = std::max(this->problem_.ny, this->problem_.nz);
+
+	std::size_t x_tile = x_tile_size_;
+	if (x_tile == 0)
+		x_tile = std::max<std::size_t>(1, tile_bytes_ / (sizeof(real_t) * substrates_count * slab_n));
+	x_tile_ = (index_t)std::min<std::size_t>(x_tile, this->problem_.nx);
+
+	constexpr std::size_t line_elements = 64 / sizeof(real_t);
+	buffer_size_ = substrates_count * std::max<std::size_t>(this->problem_.nx, x_tile_ * slab_n);
+	buffer_size_ = (buffer_size_ + line_elements - 1) / line_elements * line_elements;
+
+	buffers_ = this->allocator_.template allocate<real_t>(buffer_size_ * omp_get_max_threads());
+}
+
+// Solves the x line yz; the forward substitution results of the line are kept in the real_t buffer line
+template <typename index_t, typename real_t, typename storage_t, typename density_layout_t>
+inline void solve_line_x_mixed(storage_t* __restrict__ densities, real_t* __restrict__ line,
+							   const real_t* __restrict__ b, const real_t* __restrict__ c,
+							   const real_t* __restrict__ e, const density_layout_t dens_l, index_t yz)
+{
+	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+	const index_t n = dens_l | noarr::get_length<'x'>();
+
+	auto diag_l = noarr::scalar<real_t>() ^ noarr::vector<'s'>(substrates_count) ^ noarr::vector<'i'>(n);
+
+	auto density = [=](index_t i, index_t s) -> storage_t& {
+		return dens_l | noarr::get_at<'m', 'x', 's'>(densities, yz, i, s);
+	};
+	auto forward = [=](index_t i, index_t s) -> real_t& { return diag_l | noarr::get_at<'i', 's'>(line, i, s); };
+
+#pragma omp simd
+	for (index_t s = 0; s < substrates_count; s++)
+	{
+		forward(0, s) = density(0, s);
+	}
+
+	for (index_t i = 1; i < n; i++)
+	{
+#pragma omp simd
+		for (index_t s = 0; s < substrates_count; s++)
+		{
+			forward(i, s) = density(i, s) - (diag_l | noarr::get_at<'i', 's'>(e, i - 1, s)) * forward(i - 1, s);
+		}
+	}
+
+#pragma omp simd
+	for (index_t s = 0; s < substrates_count; s++)
+	{
+		forward(n - 1, s) *= (diag_l | noarr::get_at<'i', 's'>(b, n - 1, s));
+		density(n - 1, s) = forward(n - 1, s);
+	}
+
+	for (index_t i = n - 2; i >= 0; i--)
+	{
+#pragma omp simd
+		for (index_t s = 0; s < substrates_count; s++)
+		{
+			forward(i, s) = (forward(i, s) - c[s] * forward(i + 1, s)) * (diag_l | noarr::get_at<'i', 's'>(b, i, s));
+			density(i, s) = forward(i, s);
+		}
+	}
+}
+
+// Solves all y lines of the z slab (an x tile of it, sliced by the caller); the forward substitution results are kept
+// in the real_t buffer slab
+template <typename index_t, typename real_t, typename storage_t, typename density_layout_t>
+inline void solve_slab_y_mixed(storage_t* __restrict__ densities, real_t* __restrict__ slab,
+							   const real_t* __restrict__ b, const real_t* __restrict__ c,
+							   const real_t* __restrict__ e, const density_layout_t dens_l, index_t z)
+{
+	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+	const index_t n = dens_l | noarr::get_length<'y'>();
+	const index_t x_len = dens_l | noarr::get_length<'x'>();
+
+	auto diag_l = noarr::scalar<real_t>() ^ noarr::vector<'s'>(substrates_count) ^ noarr::vector<'i'>(n);
+	auto slab_l = noarr::scalar<real_t>() ^ noarr::vectors<'s', 'x', 'y'>(substrates_count, x_len, n);
+
+	auto density = [=](index_t y, index_t x, index_t s) -> storage_t& {
+		return dens_l | noarr::get_at<'z', 'y', 'x', 's'>(densities, z, y, x, s);
+	};
+	auto forward = [=](index_t y, index_t x, index_t s) -> real_t& {
+		return slab_l | noarr::get_at<'y', 'x', 's'>(slab, y, x, s);
+	};
+
+	for (index_t x = 0; x < x_len; x++)
+	{
+#pragma omp simd
+		for (index_t s = 0; s < substrates_count; s++)
+		{
+			forward(0, x, s) = density(0, x, s);
+		}
+	}
+
+	for (index_t i = 1; i < n; i++)
+	{
+		for (index_t x = 0; x < x_len; x++)
+		{
+#pragma omp simd
+			for (index_t s = 0; s < substrates_count; s++)
+			{
+				forward(i, x, s) =
+					density(i, x, s) - (diag_l | noarr::get_at<'i', 's'>(e, i - 1, s)) * forward(i - 1, x, s);
+			}
+		}
+	}
+
+	for (index_t x = 0; x < x_len; x++)
+	{
+#pragma omp simd
+		for (index_t s = 0; s < substrates_count; s++)
+		{
+			forward(n - 1, x, s) *= (diag_l | noarr::get_at<'i', 's'>(b, n - 1, s));
+			density(n - 1, x, s) = forward(n - 1, x, s);
+		}
+	}
+
+	for (index_t i = n - 2; i >= 0; i--)
+	{
+		for (index_t x = 0; x < x_len; x++)
+		{
+#pragma omp simd
+			for (index_t s = 0; s < substrates_count; s++)
+			{
+				forward(i, x, s) =
+					(forward(i, x, s) - c[s] * forward(i + 1, x, s)) * (diag_l | noarr::get_at<'i', 's'>(b, i, s));
+				density(i, x, s) = forward(i, x, s);
+			}
+		}
+	}
+}
+
+template <typename real_t, typename storage_t, typename index_t>
+void mixed_precision_thomas_solver<real_t, storage_t, index_t>::solve_x_omp()
+{
+	auto dens_l = get_storage_layout(this->problem_) ^ noarr::merge_blocks<'z', 'y', 'm'>();
+
+	const index_t m = dens_l | noarr::get_length<'m'>();
+
+	real_t* line = buffers_.get() + omp_get_thread_num() * buffer_size_;
+
+#pragma omp for schedule(static, this->work_items_)
+	for (index_t yz = 0; yz < m; yz++)
+	{
+		solve_line_x_mixed<index_t>(storage_.get(), line, this->bx_.get(), this->cx_.get(), this->ex_.get(), dens_l,
+									yz);
+	}
+}
+
+template <typename real_t, typename storage_t, typename index_t>
+void mixed_precision_thomas_solver<real_t, storage_t, index_t>::solve_y_omp()
+{
+	if (this->problem_.dims < 2)
+		return;
+
+	auto dens_l = get_storage_layout(this->problem_);
+
+	const index_t z_len = this->problem_.nz;
+	const index_t x_len = this->problem_.nx;
+
+	const index_t x_blocks = this->get_slab_blocks(x_len);
+
+	real_t* slab = buffers_.get() + omp_get_thread_num() * buffer_size_;
+
+#pragma omp for collapse(2) schedule(static, this->work_items_)
+	for (index_t z = 0; z < z_len; z++)
+	{
+		for (index_t block = 0; block < x_blocks; block++)
+		{
+			const index_t x_begin = block * x_len / x_blocks;
+			const index_t x_end = (block + 1) * x_len / x_blocks;
+
+			for (index_t x = x_begin; x < x_end; x += x_tile_)
+			{
+				solve_slab_y_mixed<index_t>(storage_.get(), slab, this->by_.get(), this->cy_.get(), this->ey_.get(),
+											dens_l ^ noarr::slice<'x'>(x, std::min(x_tile_, x_end - x)), z);
+			}
+		}
+	}
+}
+
+template <typename real_t, typename storage_t, typename index_t>
+void mixed_precision_thomas_solver<real_t, storage_t, index_t>::solve_z_omp()
+{
+	if (this->problem_.dims < 3)
+		return;
+
+	// a y row of the z lines is solved as a y slab with swapped y and z
+	auto dens_l = get_storage_layout(this->problem_) ^ noarr::rename<'z', 'y', 'y', 'z'>();
+
+	const index_t y_len = this->problem_.ny;
+	const index_t x_len = this->problem_.nx;
+
+	real_t* slab = buffers_.get() + omp_get_thread_num() * buffer_size_;
+
+#pragma omp for schedule(static, this->work_items_)
+	for (index_t y = 0; y < y_len; y++)
+	{
+		for (index_t x = 0; x < x_len; x += x_tile_)
+		{
+			solve_slab_y_mixed<index_t>(storage_.get(), slab, this->bz_.get(), this->cz_.get(), this->ez_.get(),
+										dens_l ^ noarr::slice<'x'>(x, std::min(x_tile_, x_len - x)), y);
+		}
+	}
+}
+
+template <typename real_t, typename storage_t, typename index_t>
+std::span<const std::byte> mixed_precision_thomas_solver<real_t, storage_t, index_t>::substrates_memory() const
+{
+	return std::as_bytes(std::span(storage_.get(), this->get_substrates_size()));
+}
+
+template <typename real_t, typename storage_t, typename index_t>
+double mixed_precision_thomas_solver<real_t, storage_t, index_t>::access(std::size_t s, std::size_t x, std::size_t y,
+																		 std::size_t z) const
+{
+	auto dens_l = get_storage_layout(this->problem_);
+
+	return (real_t)(dens_l | noarr::get_at<'s', 'x', 'y', 'z'>(storage_.get(), s, x, y, z));
+}
+
+template class mixed_precision_thomas_solver<double, float, std::int32_t>;
+template class mixed_precision_thomas_solver<double, float, std::int64_t>;
+template class mixed_precision_thomas_solver<float, bf16_t, std::int32_t>;
+template class mixed_precision_thomas_solver<float, bf16_t, std::int64_t>;
+template class mixed_precision_thomas_solver<float, fp16_t, std::int32_t>;
+template class mixed_precision_thomas_solver<float, fp16_t, std::int64_t>;
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "half_precision.h"
+#include "least_compute_thomas_solver.h"
+
+/*
+The same solver as least_compute_thomas_solver, but the densities are stored in storage_t, which is narrower than
+real_t. The precomputed b, c, e values stay in real_t. The forward substitution reads each density once, converts it
+to real_t and keeps its result in a per-thread real_t buffer (a line for the x sweep, a slab for the y and z sweeps),
+so the whole recurrence runs in real_t and each density is rounded to storage_t only once, when the backward
+substitution stores it. The memory traffic on the densities is that of storage_t.
+The y and z sweeps solve their slabs in tiles of "x_tile_size" x points, so the buffer of a tile stays in the cache
+between the forward and the backward substitution. By default, the tile is sized so that its buffer takes 128 KiB.
+E.g. float storage with double coefficients halves the traffic of the double solver and keeps the recurrence in
+double, and bf16/fp16 storage with float coefficients halves the traffic of the float solver for substrates needing
+only 3-4 significant digits.
+*/
+
+template <typename real_t, typename storage_t, typename index_t>
+class mixed_precision_thomas_solver : public least_compute_variant<real_t, index_t>
+{
+	using base_t = least_compute_variant<real_t, index_t>;
+
+	aligned_buffer<storage_t> storage_;
+
+	// the x points of the tiles of the y and z slabs; 0 in the params sizes the tile buffer to tile_bytes_
+	static constexpr std::size_t tile_bytes_ = 128 * 1024;
+	std::size_t x_tile_size_;
+	index_t x_tile_;
+
+	// the real_t forward substitution results of an x line or a slab tile, buffer_size_ elements per thread
+	aligned_buffer<real_t> buffers_;
+	std::size_t buffer_size_;
+
+	// padded as the layout of the base solver
+	auto get_storage_layout(const problem_t<index_t, real_t>& problem) const
+	{
+		return noarr::scalar<storage_t>()
+			   ^ noarr::vectors<'s', 'x', 'y', 'z'>(problem.substrates_count, problem.nx + this->pad_x_,
+													problem.ny + this->pad_y_, problem.nz)
+			   ^ noarr::slice<'x'>(0, problem.nx) ^ noarr::slice<'y'>(0, problem.ny);
+	}
+
+	void solve_x_omp() override;
+	void solve_y_omp() override;
+	void solve_z_omp() override;
+
+public:
+	void tune(const nlohmann::json& params) override;
+
+	std::size_t allocated_elements(const max_problem_t& problem) const override
+	{
+		return this->get_substrates_size(problem, sizeof(storage_t));
+	}
+
+	void prepare(const max_problem_t& problem) override;
+
+	std::span<const std::byte> substrates_memory() const override;
+
+	double access(std::size_t s, std::size_t x, std::size_t y, std::size_t z) const override;
+};
@@ -0,0 +1,136 @@
+#include "numa_utils.h"
+
+#include <cstdint>
+#include <map>
+#include <omp.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+	#include <cerrno>
+	#include <sched.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+#endif
+
+#ifdef __linux__
+
+// The CPUs of the process affinity mask before any pinning
+static const std::vector<int>& get_process_cpus()
+{
+	static const std::vector<int> cpus = [] {
+		cpu_set_t set;
+		if (sched_getaffinity(0, sizeof(set), &set) != 0)
+			throw std::runtime_error("Unable to get the process affinity mask");
+
+		std::vector<int> cpus;
+		for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+			if (CPU_ISSET(cpu, &set))
+				cpus.push_back(cpu);
+
+		return cpus;
+	}();
+
+	return cpus;
+}
+
+void numa_utils::pin_threads(const nlohmann::json& params)
+{
+	if (!params.contains("pinning") || params["pinning"] == "none")
+		return;
+
+	const auto& pinning = params["pinning"];
+	const auto& process_cpus = get_process_cpus();
+	const std::size_t threads = omp_get_max_threads();
+
+	std::vector<int> places;
+
+	if (pinning.is_array())
+		places = pinning.get<std::vector<int>>();
+	else if (pinning == "close")
+		for (std::size_t i = 0; i < threads; i++)
+			places.push_back(process_cpus[i % process_cpus.size()]);
+	else if (pinning == "spread")
+		for (std::size_t i = 0; i < threads; i++)
+			places.push_back(process_cpus[i * process_cpus.size() / threads]);
+	else
+		throw std::runtime_error("Unknown pinning: " + pinning.dump());
+
+	if (places.empty())
+		throw std::runtime_error("The pinning list is empty");
+
+	for (int cpu : places)
+		if (cpu < 0 || cpu >= CPU_SETSIZE)
+			throw std::runtime_error("Invalid CPU in the pinning list: " + std::to_string(cpu));
+
+	bool failed = false;
+
+#pragma omp parallel reduction(|| : failed)
+	{
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(places[omp_get_thread_num() % places.size()], &set);
+
+		failed = sched_setaffinity(0, sizeof(set), &set) != 0;
+	}
+
+	if (failed)
+		throw std::runtime_error("Unable to pin the threads");
+}
+
+void numa_utils::print_page_distribution(std::span<const std::byte> memory, std::ostream& os)
+{
+	if (memory.empty())
+	{
+		os << "Page distribution: not available for this algorithm" << std::endl;
+		return;
+	}
+
+	const std::uintptr_t page_size = sysconf(_SC_PAGESIZE);
+	const std::uintptr_t begin = (std::uintptr_t)memory.data() & ~(page_size - 1);
+	const std::uintptr_t end = (std::uintptr_t)(memory.data() + memory.size());
+
+	std::vector<void*> pages;
+	for (std::uintptr_t page = begin; page < end; page += page_size)
+		pages.push_back((void*)page);
+
+	// without the target nodes, move_pages only queries the nodes the pages reside on
+	std::vector<int> status(pages.size());
+	if (syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr, status.data(), 0) != 0)
+	{
+		os << "Page distribution: unable to query the page nodes" << std::endl;
+		return;
+	}
+
+	std::map<int, std::size_t> counts;
+	for (int node : status)
+		counts[node]++;
+
+	os << "Page distribution (" << pages.size() << " pages):";
+	for (auto [node, count] : counts)
+	{
+		if (node >= 0)
+			os << " node " << node << ": " << count;
+		else if (node == -ENOENT)
+			os << " not present: " << count;
+		else
+			os << " unknown: " << count;
+	}
+	os << std::endl;
+}
+
+#else
+
+void numa_utils::pin_threads(const nlohmann::json& params)
+{
+	if (params.contains("pinning") && params["pinning"] != "none")
+		throw std::runtime_error("Thread pinning is supported only on Linux");
+}
+
+void numa_utils::print_page_distribution(std::span<const std::byte>, std::ostream& os)
+{
+	os << "Page distribution: supported only on Linux" << std::endl;
+}
+
+#endif
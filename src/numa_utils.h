@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <span>
+
+#include <nlohmann/json.hpp>
+
+class numa_utils
+{
+public:
+	// Pins the OpenMP threads according to the "pinning" parameter:
+	// - "none" (default) keeps the affinity as is,
+	// - "close" pins the thread i to the i-th CPU of the process affinity mask,
+	// - "spread" distributes the threads evenly over the CPUs of the process affinity mask,
+	// - a list of CPU ids pins the thread i to the (i mod size)-th CPU of the list.
+	// The threads are pinned before the substrates are allocated, so the first touch places the pages next to them.
+	static void pin_threads(const nlohmann::json& params);
+
+	// Prints the number of pages of the memory residing on each NUMA node
+	static void print_page_distribution(std::span<const std::byte> memory, std::ostream& os);
+};
@@ -1,9 +1,14 @@
 #pragma once
 
+#include "isa_dispatch.h"
+
 template <typename T, typename F>
 inline void omp_trav_for_each(const T& trav, const F& f)
 {
-#pragma omp parallel for
-	for (auto trav_inner : trav)
-		trav_inner.for_each(f);
+#pragma omp parallel
+	isa_dispatch::run([&] {
+#pragma omp for
+		for (auto trav_inner : trav)
+			trav_inner.for_each(f);
+	});
 }
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <algorithm>
+#include <utility>
+
+#include <noarr/structures_extended.hpp>
+#include <omp.h>
+
+#include "aligned_allocator.h"
+
+// The partitioned (SPIKE-like) variant of the least_memory solver (see least_memory_thomas_solver.h). The kernel takes
+// the densities buffer and its layout, so any solver can run it on its own buffer as long as the layout provides the
+// dimensions 'i', 'q', 'm' and 's'.
+
+template <typename real_t, typename index_t>
+struct partitioned_values_t
+{
+	index_t chunks;
+
+	// modified forward substitution factors and the first row factors of the backward substitution
+	aligned_buffer<real_t> r, c_forward, r_first;
+
+	// couplings of the inner rows to the first and the last row of their chunk
+	aligned_buffer<real_t> a_final, c_final;
+
+	// precomputed Thomas values of the reduced system
+	aligned_buffer<real_t> reduced_b, reduced_c, reduced_e;
+};
+
+template <typename index_t>
+inline std::pair<index_t, index_t> get_chunk_bounds(index_t chunk, index_t chunks, index_t n)
+{
+	return { chunk * n / chunks, (chunk + 1) * n / chunks };
+}
+
+// Precomputes the partitioned values of lines of n rows; a and b0 are the per-substrate off-diagonal and boundary
+// diagonal values of least_memory_thomas_solver::precompute_values
+template <typename real_t, typename index_t>
+void precompute_partitioned_values(partitioned_values_t<real_t, index_t>& values, const aligned_allocator& allocator,
+								   const real_t* a, const real_t* b0, index_t n, index_t substrates_count)
+{
+	values.chunks = std::max<index_t>(1, std::min<index_t>(omp_get_max_threads(), n / 3));
+
+	values.r = allocator.allocate<real_t>(n * substrates_count);
+	values.c_forward = allocator.allocate<real_t>(n * substrates_count);
+	values.a_final = allocator.allocate<real_t>(n * substrates_count);
+	values.c_final = allocator.allocate<real_t>(n * substrates_count);
+	values.r_first = allocator.allocate<real_t>(values.chunks * substrates_count);
+	values.reduced_b = allocator.allocate<real_t>(2 * values.chunks * substrates_count);
+	values.reduced_c = allocator.allocate<real_t>(2 * values.chunks * substrates_count);
+	values.reduced_e = allocator.allocate<real_t>(2 * values.chunks * substrates_count);
+
+	auto diag_l = noarr::scalar<real_t>() ^ noarr::vectors<'i', 's'>(n, substrates_count);
+	auto chunk_l = noarr::scalar<real_t>() ^ noarr::vectors<'k', 's'>(values.chunks, substrates_count);
+	auto reduced_l = noarr::scalar<real_t>() ^ noarr::vectors<'r', 's'>(2 * values.chunks, substrates_count);
+
+	auto r = noarr::make_bag(diag_l, values.r.get());
+	auto c_forward = noarr::make_bag(diag_l, values.c_forward.get());
+	auto a_final = noarr::make_bag(diag_l, values.a_final.get());
+	auto c_final = noarr::make_bag(diag_l, values.c_final.get());
+
+	for (index_t s = 0; s < substrates_count; s++)
+	{
+		auto b = [&](index_t i) { return (i == 0 || i == n - 1) ? b0[s] : b0[s] - a[s]; };
+
+		for (index_t k = 0; k < values.chunks; k++)
+		{
+			auto [begin, end] = get_chunk_bounds(k, values.chunks, n);
+
+			// modified forward substitution
+			for (index_t i = begin; i < begin + 2; i++)
+			{
+				r.template at<'i', 's'>(i, s) = 1 / b(i);
+				a_final.template at<'i', 's'>(i, s) = (i == 0 ? 0 : a[s]) * r.template at<'i', 's'>(i, s);
+				c_forward.template at<'i', 's'>(i, s) = a[s] * r.template at<'i', 's'>(i, s);
+			}
+
+			for (index_t i = begin + 2; i < end; i++)
+			{
+				r.template at<'i', 's'>(i, s) = 1 / (b(i) - a[s] * c_forward.template at<'i', 's'>(i - 1, s));
+				a_final.template at<'i', 's'>(i, s) =
+					-a[s] * a_final.template at<'i', 's'>(i - 1, s) * r.template at<'i', 's'>(i, s);
+				c_forward.template at<'i', 's'>(i, s) = (i == n - 1 ? 0 : a[s]) * r.template at<'i', 's'>(i, s);
+			}
+
+			// modified backward substitution
+			for (index_t i = end - 2; i < end; i++)
+				c_final.template at<'i', 's'>(i, s) = c_forward.template at<'i', 's'>(i, s);
+
+			for (index_t i = end - 3; i > begin; i--)
+			{
+				a_final.template at<'i', 's'>(i, s) -=
+					c_forward.template at<'i', 's'>(i, s) * a_final.template at<'i', 's'>(i + 1, s);
+				c_final.template at<'i', 's'>(i, s) =
+					-c_forward.template at<'i', 's'>(i, s) * c_final.template at<'i', 's'>(i + 1, s);
+			}
+
+			{
+				real_t r_first =
+					1 / (1 - c_forward.template at<'i', 's'>(begin, s) * a_final.template at<'i', 's'>(begin + 1, s));
+
+				(chunk_l | noarr::get_at<'k', 's'>(values.r_first.get(), k, s)) = r_first;
+				a_final.template at<'i', 's'>(begin, s) *= r_first;
+				c_final.template at<'i', 's'>(begin, s) = -r_first * c_forward.template at<'i', 's'>(begin, s)
+														  * c_final.template at<'i', 's'>(begin + 1, s);
+			}
+		}
+
+		// Thomas values of the reduced system, where the row 2k is the first and the row 2k+1 is the last row of
+		// chunk k; the reduced diagonal is 1
+		real_t prev_b = 0, prev_c = 0;
+		for (index_t row = 0; row < 2 * values.chunks; row++)
+		{
+			auto [begin, end] = get_chunk_bounds(row / 2, values.chunks, n);
+			const index_t i = row % 2 == 0 ? begin : end - 1;
+
+			const real_t reduced_a = a_final.template at<'i', 's'>(i, s);
+			const real_t reduced_c = c_final.template at<'i', 's'>(i, s);
+
+			const real_t reduced_e = row == 0 ? 0 : reduced_a * prev_b;
+			const real_t reduced_b = 1 / (1 - reduced_e * prev_c);
+
+			(reduced_l | noarr::get_at<'r', 's'>(values.reduced_b.get(), row, s)) = reduced_b;
+			(reduced_l | noarr::get_at<'r', 's'>(values.reduced_c.get(), row, s)) = reduced_c;
+			(reduced_l | noarr::get_at<'r', 's'>(values.reduced_e.get(), row, s)) = reduced_e;
+
+			prev_b = reduced_b;
+			prev_c = reduced_c;
+		}
+	}
+}
+
+// Solves the lines along 'i' by the partitioned algorithm; 'q' and 'm' enumerate the lines inside and outside of 'i'
+template <typename index_t, typename real_t, typename values_t, typename density_layout_t>
+void solve_slice_partitioned(real_t* __restrict__ densities, const real_t* __restrict__ a,
+							 const values_t& values, const density_layout_t dens_l)
+{
+	const index_t chunks = values.chunks;
+	const real_t* __restrict__ r = values.r.get();
+	const real_t* __restrict__ c_forward = values.c_forward.get();
+	const real_t* __restrict__ r_first = values.r_first.get();
+	const real_t* __restrict__ a_final = values.a_final.get();
+	const real_t* __restrict__ c_final = values.c_final.get();
+	const real_t* __restrict__ reduced_b = values.reduced_b.get();
+	const real_t* __restrict__ reduced_c = values.reduced_c.get();
+	const real_t* __restrict__ reduced_e = values.reduced_e.get();
+
+	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+	const index_t n = dens_l | noarr::get_length<'i'>();
+	const index_t q_len = dens_l | noarr::get_length<'q'>();
+	const index_t m_len = dens_l | noarr::get_length<'m'>();
+
+	auto diag_l = noarr::scalar<real_t>() ^ noarr::vectors<'i', 's'>(n, substrates_count);
+	auto chunk_l = noarr::scalar<real_t>() ^ noarr::vectors<'k', 's'>(chunks, substrates_count);
+	auto reduced_l = noarr::scalar<real_t>() ^ noarr::vectors<'r', 's'>(2 * chunks, substrates_count);
+
+	// modified forward and backward substitution of each chunk
+#pragma omp for schedule(static)
+	for (index_t k = 0; k < chunks; k++)
+	{
+		auto [begin, end] = get_chunk_bounds(k, chunks, n);
+
+		for (index_t s = 0; s < substrates_count; s++)
+		{
+			for (index_t m = 0; m < m_len; m++)
+			{
+				for (index_t i = begin; i < begin + 2; i++)
+				{
+#pragma omp simd
+					for (index_t q = 0; q < q_len; q++)
+					{
+						(dens_l | noarr::get_at<'s', 'm', 'i', 'q'>(densities, s, m, i, q)) *=
+							(diag_l | noarr::get_at<'i', 's'>(r, i, s));
+					}
+				}
+
+				for (index_t i = begin + 2; i < end; i++)
+				{
+#pragma omp simd
+					for (index_t q = 0; q < q_len; q++)
+					{
+						(dens_l | noarr::get_at<'s', 'm', 'i', 'q'>(densities, s, m, i, q)) =
+							((dens_l | noarr::get_at<'s', 'm', 'i', 'q'>(densities, s, m, i, q))
+							 - a[s] * (dens_l | noarr::get_at<'s', 'm', 'i', 'q'>(densities, s, m, i - 1, q)))
+							* (diag_l | noarr::get_at<'i', 's'>(r, i, s));
+					}
+				}
+
+				for (index_t i = end - 3; i > begin; i--)
+				{
+#pragma omp simd
+					for (index_t q = 0; q < q_len; q++)
+					{
+						(dens_l | noarr::get_at<'s', 'm', 'i', 'q'>(densities, s, m, i, q)) -=
+							(diag_l | noarr::get_at<'i', 's'>(c_forward, i, s))
+							* (dens_l | noarr::get_at<'s', 'm', 'i', 'q'>(densities, s, m, i + 1, q));
+					}
+				}
+
+#pragma omp simd
+				for (index_t q = 0; q < q_len; q++)
+				{
+					(dens_l | noarr::get_at<'s', 'm', 'i', 'q'>(densities, s, m, begin, q)) =
+						((dens_l | noarr::get_at<'s', 'm', 'i', 'q'>(densities, s, m, begin, q))
+						 - (diag_l | noarr::get_at<'i', 's'>(c_forward, begin, s))
+							   * (dens_l | noarr::get_at<'s', 'm', 'i', 'q'>(densities, s, m, begin + 1, q)))
+						* (chunk_l | noarr::get_at<'k', 's'>(r_first, k, s));
+				}
+			}
+		}
+	}
+
+	// Thomas solve of the reduced system made of the first and the last rows of the chunks
+	auto reduced_row = [chunks, n](index_t row) {
+		auto [begin, end] = get_chunk_bounds(row / 2, chunks, n);
+		return row % 2 == 0 ? begin : end - 1;
+	};
+
+#pragma omp for schedule(static) collapse(3)
+	for (index_t s = 0; s < substrates_count; s++)
+	{
+		for (index_t m = 0; m < m_len; m++)
+		{
+			for (index_t q = 0; q < q_len; q++)
+			{
+				for (index_t row = 1; row < 2 * chunks; row++)
+				{
+					(dens_l | noarr::get_at<'s', 'm', 'i', 'q'>(densities, s, m, reduced_row(row), q)) -=
+						(reduced_l | noarr::get_at<'r', 's'>(reduced_e, row, s))
+						* (dens_l | noarr::get_at<'s', 'm', 'i', 'q'>(densities, s, m, reduced_row(row - 1), q));
+				}
+
+				(dens_l | noarr::get_at<'s', 'm', 'i', 'q'>(densities, s, m, n - 1, q)) *=
+					(reduced_l | noarr::get_at<'r', 's'>(reduced_b, 2 * chunks - 1, s));
+
+				for (index_t row = 2 * chunks - 2; row >= 0; row--)
+				{
+					(dens_l | noarr::get_at<'s', 'm', 'i', 'q'>(densities, s, m, reduced_row(row), q)) =
+						((dens_l | noarr::get_at<'s', 'm', 'i', 'q'>(densities, s, m, reduced_row(row), q))
+						 - (reduced_l | noarr::get_at<'r', 's'>(reduced_c, row, s))
+							   * (dens_l
+								  | noarr::get_at<'s', 'm', 'i', 'q'>(densities, s, m, reduced_row(row + 1), q)))
+						* (reduced_l | noarr::get_at<'r', 's'>(reduced_b, row, s));
+				}
+			}
+		}
+	}
+
+	// back-fill of the inner rows of each chunk
+#pragma omp for schedule(static) nowait
+	for (index_t k = 0; k < chunks; k++)
+	{
+		auto [begin, end] = get_chunk_bounds(k, chunks, n);
+
+		for (index_t s = 0; s < substrates_count; s++)
+		{
+			for (index_t m = 0; m < m_len; m++)
+			{
+				for (index_t i = begin + 1; i < end - 1; i++)
+				{
+#pragma omp simd
+					for (index_t q = 0; q < q_len; q++)
+					{
+						(dens_l | noarr::get_at<'s', 'm', 'i', 'q'>(densities, s, m, i, q)) -=
+							(diag_l | noarr::get_at<'i', 's'>(a_final, i, s))
+								* (dens_l | noarr::get_at<'s', 'm', 'i', 'q'>(densities, s, m, begin, q))
+							+ (diag_l | noarr::get_at<'i', 's'>(c_final, i, s))
+								  * (dens_l | noarr::get_at<'s', 'm', 'i', 'q'>(densities, s, m, end - 1, q));
+					}
+				}
+			}
+		}
+	}
+}
@@ -5,14 +5,14 @@
 
 #include "solver_utils.h"
 
-template <typename real_t>
-void reference_thomas_solver<real_t>::precompute_values(std::unique_ptr<real_t[]>& a, std::unique_ptr<real_t[]>& b,
-														std::unique_ptr<real_t[]>& b0, index_t shape, index_t dims,
+template <typename real_t, typename index_t>
+void reference_thomas_solver<real_t, index_t>::precompute_values(aligned_buffer<real_t>& a, aligned_buffer<real_t>& b,
+														aligned_buffer<real_t>& b0, index_t shape, index_t dims,
 														index_t n)
 {
-	a = std::make_unique<real_t[]>(problem_.substrates_count);
-	b = std::make_unique<real_t[]>(problem_.substrates_count * n);
-	b0 = std::make_unique<real_t[]>(problem_.substrates_count);
+	a = allocator_.allocate<real_t>(problem_.substrates_count);
+	b = allocator_.allocate<real_t>(problem_.substrates_count * n);
+	b0 = allocator_.allocate<real_t>(problem_.substrates_count);
 
 	auto l = noarr::scalar<real_t>() ^ noarr::vectors<'s', 'i'>(problem_.substrates_count, n);
 
@@ -37,18 +37,18 @@ void reference_thomas_solver<real_t>::precompute_values(std::unique_ptr<real_t[]
 					(b0[s]) - (a[s] * a[s]) / (l | noarr::get_at<'s', 'i'>(b.get(), s, i - 1));
 }
 
-template <typename real_t>
-auto reference_thomas_solver<real_t>::get_substrates_layout(const problem_t<index_t, real_t>& problem)
+template <typename real_t, typename index_t>
+auto reference_thomas_solver<real_t, index_t>::get_substrates_layout(const problem_t<index_t, real_t>& problem)
 {
 	return noarr::scalar<real_t>()
 		   ^ noarr::vectors<'s', 'x', 'y', 'z'>(problem.substrates_count, problem.nx, problem.ny, problem.nz);
 }
 
-template <typename real_t>
-void reference_thomas_solver<real_t>::prepare(const max_problem_t& problem)
+template <typename real_t, typename index_t>
+void reference_thomas_solver<real_t, index_t>::prepare(const max_problem_t& problem)
 {
-	problem_ = problems::cast<std::int32_t, real_t>(problem);
-	substrates_ = std::make_unique<real_t[]>(problem_.nx * problem_.ny * problem_.nz * problem_.substrates_count);
+	problem_ = problems::cast<index_t, real_t>(problem);
+	substrates_ = allocator_.allocate<real_t>(problem_.nx * problem_.ny * problem_.nz * problem_.substrates_count);
 
 	// Initialize substrates
 
@@ -57,8 +57,8 @@ void reference_thomas_solver<real_t>::prepare(const max_problem_t& problem)
 	solver_utils::initialize_substrate(substrates_layout, substrates_.get(), problem_);
 }
 
-template <typename real_t>
-void reference_thomas_solver<real_t>::initialize()
+template <typename real_t, typename index_t>
+void reference_thomas_solver<real_t, index_t>::initialize()
 {
 	if (problem_.dims >= 1)
 		precompute_values(ax_, bx_, b0x_, problem_.dx, problem_.dims, problem_.nx);
@@ -68,8 +68,8 @@ void reference_thomas_solver<real_t>::initialize()
 		precompute_values(az_, bz_, b0z_, problem_.dz, problem_.dims, problem_.nz);
 }
 
-template <typename real_t>
-void reference_thomas_solver<real_t>::solve_x()
+template <typename real_t, typename index_t>
+void reference_thomas_solver<real_t, index_t>::solve_x()
 {
 	auto dens_l = get_substrates_layout(problem_);
 	auto diag_l = noarr::scalar<real_t>() ^ noarr::vectors<'s', 'i'>(problem_.substrates_count, problem_.nx);
@@ -108,9 +108,12 @@ void reference_thomas_solver<real_t>::solve_x()
 	}
 }
 
-template <typename real_t>
-void reference_thomas_solver<real_t>::solve_y()
+template <typename real_t, typename index_t>
+void reference_thomas_solver<real_t, index_t>::solve_y()
 {
+	if (problem_.dims < 2)
+		return;
+
 	auto dens_l = get_substrates_layout(problem_);
 	auto diag_l = noarr::scalar<real_t>() ^ noarr::vectors<'s', 'i'>(problem_.substrates_count, problem_.ny);
 
@@ -160,9 +163,12 @@ void reference_thomas_solver<real_t>::solve_y()
 	}
 }
 
-template <typename real_t>
-void reference_thomas_solver<real_t>::solve_z()
+template <typename real_t, typename index_t>
+void reference_thomas_solver<real_t, index_t>::solve_z()
 {
+	if (problem_.dims < 3)
+		return;
+
 	auto dens_l = get_substrates_layout(problem_);
 	auto diag_l = noarr::scalar<real_t>() ^ noarr::vectors<'s', 'i'>(problem_.substrates_count, problem_.nz);
 
@@ -212,8 +218,8 @@ void reference_thomas_solver<real_t>::solve_z()
 	}
 }
 
-template <typename real_t>
-void reference_thomas_solver<real_t>::save(const std::string& file) const
+template <typename real_t, typename index_t>
+void reference_thomas_solver<real_t, index_t>::save(const std::string& file) const
 {
 	auto dens_l = get_substrates_layout(problem_);
 
@@ -231,13 +237,23 @@ void reference_thomas_solver<real_t>::save(const std::string& file) const
 	out.close();
 }
 
-template <typename real_t>
-double reference_thomas_solver<real_t>::access(std::size_t s, std::size_t x, std::size_t y, std::size_t z) const
+template <typename real_t, typename index_t>
+std::span<const std::byte> reference_thomas_solver<real_t, index_t>::substrates_memory() const
+{
+	return std::as_bytes(
+		std::span(substrates_.get(), problem_.nx * problem_.ny * problem_.nz * problem_.substrates_count));
+}
+
+template <typename real_t, typename index_t>
+double reference_thomas_solver<real_t, index_t>::access(std::size_t s, std::size_t x, std::size_t y,
+														std::size_t z) const
 {
 	auto dens_l = get_substrates_layout(problem_);
 
 	return (dens_l | noarr::get_at<'s', 'x', 'y', 'z'>(substrates_.get(), s, x, y, z));
 }
 
-template class reference_thomas_solver<float>;
-template class reference_thomas_solver<double>;
+template class reference_thomas_solver<float, std::int32_t>;
+template class reference_thomas_solver<float, std::int64_t>;
+template class reference_thomas_solver<double, std::int32_t>;
+template class reference_thomas_solver<double, std::int64_t>;
@@ -2,24 +2,25 @@
 
 #include <memory>
 
+#include "aligned_allocator.h"
 #include "tridiagonal_solver.h"
 
-template <typename real_t>
+template <typename real_t, typename index_t>
 class reference_thomas_solver : public tridiagonal_solver
 {
-	using index_t = std::int32_t;
-
 	problem_t<index_t, real_t> problem_;
 
-	std::unique_ptr<real_t[]> substrates_;
+	aligned_allocator allocator_;
+
+	aligned_buffer<real_t> substrates_;
 
-	std::unique_ptr<real_t[]> ax_, b0x_, bx_;
-	std::unique_ptr<real_t[]> ay_, b0y_, by_;
-	std::unique_ptr<real_t[]> az_, b0z_, bz_;
+	aligned_buffer<real_t> ax_, b0x_, bx_;
+	aligned_buffer<real_t> ay_, b0y_, by_;
+	aligned_buffer<real_t> az_, b0z_, bz_;
 
 	static auto get_substrates_layout(const problem_t<index_t, real_t>& problem);
 
-	void precompute_values(std::unique_ptr<real_t[]>& a, std::unique_ptr<real_t[]>& b, std::unique_ptr<real_t[]>& b0,
+	void precompute_values(aligned_buffer<real_t>& a, aligned_buffer<real_t>& b, aligned_buffer<real_t>& b0,
 						   index_t shape, index_t dims, index_t n);
 
 public:
@@ -33,5 +34,7 @@ public:
 
 	void save(const std::string& file) const override;
 
+	std::span<const std::byte> substrates_memory() const override;
+
 	double access(std::size_t s, std::size_t x, std::size_t y, std::size_t z) const override;
 };
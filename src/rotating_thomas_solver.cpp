@@ -0,0 +1,269 @@
+#include "rotating_thomas_solver.h"
+
+#include <algorithm>
+
+#include "solver_utils.h"
+
+template <typename real_t, typename index_t>
+void rotating_thomas_solver<real_t, index_t>::tune(const nlohmann::json& params)
+{
+	base_t::tune(params);
+
+	tile_ = params.contains("rotation_tile") ? (index_t)params["rotation_tile"] : 16;
+}
+
+template <typename real_t, typename index_t>
+void rotating_thomas_solver<real_t, index_t>::prepare(const max_problem_t& problem)
+{
+	this->problem_ = problems::cast<index_t, real_t>(problem);
+	this->substrates_ = this->allocator_.template allocate<real_t>(get_size());
+	rotated_ = this->allocator_.template allocate<real_t>(get_size());
+
+	axis_ = 0;
+
+	// Initialize substrates
+
+	auto substrates_layout = get_rotated_layout<'x', 'z', 'y'>(this->problem_.substrates_count);
+
+	solver_utils::first_touch<'x'>(substrates_layout, this->substrates_.get(), this->work_items_);
+	solver_utils::first_touch<'x'>(substrates_layout, rotated_.get(), this->work_items_);
+
+	solver_utils::initialize_substrate(substrates_layout, this->substrates_.get(), this->problem_);
+}
+
+template <typename real_t, typename index_t>
+void rotating_thomas_solver<real_t, index_t>::initialize()
+{
+	// the values are repeated for the b dimension points of a tile, so a row of a tile is a single vector loop
+	if (this->problem_.dims >= 1)
+		this->precompute_values(this->bx_, this->cx_, this->ex_, this->problem_.dx, this->problem_.dims,
+								this->problem_.nx, tile_);
+	if (this->problem_.dims >= 2)
+		this->precompute_values(this->by_, this->cy_, this->ey_, this->problem_.dy, this->problem_.dims,
+								this->problem_.ny, tile_);
+	if (this->problem_.dims >= 3)
+		this->precompute_values(this->bz_, this->cz_, this->ez_, this->problem_.dz, this->problem_.dims,
+								this->problem_.nz, tile_);
+}
+
+// Writes the row r of the tile (r, a, b) to the layout of the next sweep (b, r, a)
+template <typename index_t, typename real_t, typename src_layout_t, typename dst_layout_t>
+inline void transpose_tile_row(real_t* __restrict__ src, real_t* __restrict__ dst, const src_layout_t src_l,
+							   const dst_layout_t dst_l, index_t r)
+{
+	const index_t substrates_count = src_l | noarr::get_length<'s'>();
+	const index_t a_len = src_l | noarr::get_length<'a'>();
+	const index_t b_len = src_l | noarr::get_length<'b'>();
+
+	for (index_t b = 0; b < b_len; b++)
+	{
+		for (index_t a = 0; a < a_len; a++)
+		{
+#pragma omp simd
+			for (index_t s = 0; s < substrates_count; s++)
+			{
+				(dst_l | noarr::get_at<'r', 'a', 'b', 's'>(dst, r, a, b, s)) =
+					(src_l | noarr::get_at<'r', 'a', 'b', 's'>(src, r, a, b, s));
+			}
+		}
+	}
+}
+
+// Solves the r lines of the tile in place and writes each row right after its backward substitution transposed to
+// dst; the b points and substrates of a row are contiguous (merged to 'q') and the values are repeated for copies b
+// points
+template <typename index_t, typename real_t, typename src_layout_t, typename dst_layout_t>
+inline void solve_tile_rotate(real_t* __restrict__ src, real_t* __restrict__ dst, const real_t* __restrict__ b,
+							  const real_t* __restrict__ c, const real_t* __restrict__ e, const src_layout_t src_l,
+							  const dst_layout_t dst_l, index_t copies)
+{
+	const index_t substrates_count = src_l | noarr::get_length<'s'>();
+	const index_t n = src_l | noarr::get_length<'r'>();
+	const index_t a_len = src_l | noarr::get_length<'a'>();
+
+	auto q_l = src_l ^ noarr::merge_blocks<'b', 's', 'q'>();
+	const index_t q_len = q_l | noarr::get_length<'q'>();
+
+	auto diag_l = noarr::scalar<real_t>() ^ noarr::vector<'q'>(copies * substrates_count) ^ noarr::vector<'i'>(n);
+
+	for (index_t r = 1; r < n; r++)
+	{
+		for (index_t a = 0; a < a_len; a++)
+		{
+#pragma omp simd
+			for (index_t q = 0; q < q_len; q++)
+			{
+				(q_l | noarr::get_at<'r', 'a', 'q'>(src, r, a, q)) -=
+					(diag_l | noarr::get_at<'i', 'q'>(e, r - 1, q))
+					* (q_l | noarr::get_at<'r', 'a', 'q'>(src, r - 1, a, q));
+			}
+		}
+	}
+
+	for (index_t a = 0; a < a_len; a++)
+	{
+#pragma omp simd
+		for (index_t q = 0; q < q_len; q++)
+		{
+			(q_l | noarr::get_at<'r', 'a', 'q'>(src, n - 1, a, q)) *= (diag_l | noarr::get_at<'i', 'q'>(b, n - 1, q));
+		}
+	}
+
+	transpose_tile_row<index_t>(src, dst, src_l, dst_l, n - 1);
+
+	for (index_t r = n - 2; r >= 0; r--)
+	{
+		for (index_t a = 0; a < a_len; a++)
+		{
+#pragma omp simd
+			for (index_t q = 0; q < q_len; q++)
+			{
+				(q_l | noarr::get_at<'r', 'a', 'q'>(src, r, a, q)) =
+					((q_l | noarr::get_at<'r', 'a', 'q'>(src, r, a, q))
+					 - c[q] * (q_l | noarr::get_at<'r', 'a', 'q'>(src, r + 1, a, q)))
+					* (diag_l | noarr::get_at<'i', 'q'>(b, r, q));
+			}
+		}
+
+		transpose_tile_row<index_t>(src, dst, src_l, dst_l, r);
+	}
+}
+
+// Distributes the tiles of the (a, b) plane among the threads; with null b, the tiles are only transposed
+template <typename index_t, typename real_t, typename src_layout_t, typename dst_layout_t>
+void solve_slice_rotate(real_t* __restrict__ src, real_t* __restrict__ dst, const real_t* __restrict__ b,
+						const real_t* __restrict__ c, const real_t* __restrict__ e, const src_layout_t src_l,
+						const dst_layout_t dst_l, index_t tile, std::size_t work_items)
+{
+	const index_t n = src_l | noarr::get_length<'r'>();
+	const index_t a_len = src_l | noarr::get_length<'a'>();
+	const index_t b_len = src_l | noarr::get_length<'b'>();
+
+	const index_t a_tiles = (a_len + tile - 1) / tile;
+	const index_t b_tiles = (b_len + tile - 1) / tile;
+
+#pragma omp for collapse(2) schedule(static, work_items)
+	for (index_t a_tile = 0; a_tile < a_tiles; a_tile++)
+	{
+		for (index_t b_tile = 0; b_tile < b_tiles; b_tile++)
+		{
+			const index_t a_begin = a_tile * tile;
+			const index_t b_begin = b_tile * tile;
+			const index_t a_count = std::min(tile, a_len - a_begin);
+			const index_t b_count = std::min(tile, b_len - b_begin);
+
+			auto src_tile_l = src_l ^ noarr::slice<'a'>(a_begin, a_count) ^ noarr::slice<'b'>(b_begin, b_count);
+			auto dst_tile_l = dst_l ^ noarr::slice<'a'>(a_begin, a_count) ^ noarr::slice<'b'>(b_begin, b_count);
+
+			if (b == nullptr)
+			{
+				for (index_t r = 0; r < n; r++)
+					transpose_tile_row<index_t>(src, dst, src_tile_l, dst_tile_l, r);
+			}
+			else
+			{
+				solve_tile_rotate<index_t>(src, dst, b, c, e, src_tile_l, dst_tile_l, tile);
+			}
+		}
+	}
+}
+
+template <typename real_t, typename index_t>
+template <char r_dim, char a_dim, char b_dim>
+void rotating_thomas_solver<real_t, index_t>::rotate_omp(const real_t* b, const real_t* c, const real_t* e)
+{
+	solver_utils::dispatch_substrates_count(
+		this->problem_.substrates_count, this->specialized_, [&](auto substrates_count) {
+			auto src_l = get_rotated_layout<r_dim, a_dim, b_dim>(substrates_count)
+						 ^ noarr::rename<r_dim, 'r', a_dim, 'a', b_dim, 'b'>();
+			auto dst_l = get_rotated_layout<b_dim, r_dim, a_dim>(substrates_count)
+						 ^ noarr::rename<r_dim, 'r', a_dim, 'a', b_dim, 'b'>();
+
+			solve_slice_rotate<index_t>(this->substrates_.get(), rotated_.get(), b, c, e, src_l, dst_l, tile_,
+										this->work_items_);
+		});
+
+	// the implicit barrier of the loop above guarantees all threads are done with the buffers
+#pragma omp single
+	{
+		this->substrates_.swap(rotated_);
+		axis_ = next_axis(axis_);
+	}
+}
+
+template <typename real_t, typename index_t>
+void rotating_thomas_solver<real_t, index_t>::rotate_to_omp(index_t axis)
+{
+	// a 2D y layout (y, x, z) has unit z, so it is also (y, z, x), whose transpose is the x layout (x, z, y)
+	while (axis_ != axis)
+	{
+		if (axis_ == 0)
+			rotate_omp<'x', 'z', 'y'>(nullptr, nullptr, nullptr);
+		else if (axis_ == 1 && this->problem_.dims == 2)
+			rotate_omp<'y', 'z', 'x'>(nullptr, nullptr, nullptr);
+		else if (axis_ == 1)
+			rotate_omp<'y', 'x', 'z'>(nullptr, nullptr, nullptr);
+		else
+			rotate_omp<'z', 'y', 'x'>(nullptr, nullptr, nullptr);
+	}
+}
+
+template <typename real_t, typename index_t>
+void rotating_thomas_solver<real_t, index_t>::solve_x_omp()
+{
+	rotate_to_omp(0);
+
+	rotate_omp<'x', 'z', 'y'>(this->bx_.get(), this->cx_.get(), this->ex_.get());
+}
+
+template <typename real_t, typename index_t>
+void rotating_thomas_solver<real_t, index_t>::solve_y_omp()
+{
+	if (this->problem_.dims < 2)
+		return;
+
+	rotate_to_omp(1);
+
+	if (this->problem_.dims == 2)
+		rotate_omp<'y', 'z', 'x'>(this->by_.get(), this->cy_.get(), this->ey_.get());
+	else
+		rotate_omp<'y', 'x', 'z'>(this->by_.get(), this->cy_.get(), this->ey_.get());
+}
+
+template <typename real_t, typename index_t>
+void rotating_thomas_solver<real_t, index_t>::solve_z_omp()
+{
+	if (this->problem_.dims < 3)
+		return;
+
+	rotate_to_omp(2);
+
+	rotate_omp<'z', 'y', 'x'>(this->bz_.get(), this->cz_.get(), this->ez_.get());
+}
+
+template <typename real_t, typename index_t>
+std::span<const std::byte> rotating_thomas_solver<real_t, index_t>::substrates_memory() const
+{
+	return std::as_bytes(std::span(this->substrates_.get(), get_size()));
+}
+
+template <typename real_t, typename index_t>
+double rotating_thomas_solver<real_t, index_t>::access(std::size_t s, std::size_t x, std::size_t y,
+													  std::size_t z) const
+{
+	const index_t substrates_count = this->problem_.substrates_count;
+
+	if (axis_ == 0)
+		return (get_rotated_layout<'x', 'z', 'y'>(substrates_count)
+				| noarr::get_at<'s', 'x', 'y', 'z'>(this->substrates_.get(), s, x, y, z));
+	if (axis_ == 1)
+		return (get_rotated_layout<'y', 'x', 'z'>(substrates_count)
+				| noarr::get_at<'s', 'x', 'y', 'z'>(this->substrates_.get(), s, x, y, z));
+	return (get_rotated_layout<'z', 'y', 'x'>(substrates_count)
+			| noarr::get_at<'s', 'x', 'y', 'z'>(this->substrates_.get(), s, x, y, z));
+}
+
+template class rotating_thomas_solver<float, std::int32_t>;
+template class rotating_thomas_solver<float, std::int64_t>;
+template class rotating_thomas_solver<double, std::int32_t>;
+template class rotating_thomas_solver<double, std::int64_t>;
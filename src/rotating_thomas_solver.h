@@ -0,0 +1,94 @@
+#pragma once
+
+#include "least_compute_thomas_solver.h"
+
+/*
+The same systems as least_compute_thomas_solver, but the densities are stored so that the dimension of the current
+sweep is the outermost one. The layout rotates with the sweeps x -> y -> z -> x (x -> y -> x in 2D):
+x sweep: x, z, y, s (from the outermost)
+y sweep: y, x, z, s
+z sweep: z, y, x, s
+So a row of the recurrence is a whole plane, whose points and substrates are contiguous, and every sweep is a unit
+stride vector loop over a tile of the plane.
+
+The rotation is a transpose of the outermost and the innermost spatial dimension pairs (e.g. x, z | y -> y | x, z), so
+the sweep writes each row of a tile, right after its backward substitution, transposed to the other buffer in the
+layout of the next sweep. The tiles are "rotation_tile" (16 by default) points wide in both plane dimensions, which
+keeps both the tile column of the recurrence and the transposed rows in the cache.
+
+A sweep called out of order (e.g. solve_y right after prepare) first rotates the densities by plain transposes, so
+the benchmark times of the single sweeps include the transposes; comparing them with lstc shows whether the
+rotation pays off.
+*/
+
+template <typename real_t, typename index_t>
+class rotating_thomas_solver : public least_compute_variant<real_t, index_t>
+{
+	using base_t = least_compute_variant<real_t, index_t>;
+
+	// the densities transposed by the last sweep, swapped with substrates_ after each sweep
+	aligned_buffer<real_t> rotated_;
+
+	// the dimension whose sweep the current layout serves: 0 for x, 1 for y, 2 for z
+	index_t axis_;
+
+	index_t tile_;
+
+	index_t get_length(char dim) const
+	{
+		return dim == 'x' ? this->problem_.nx : (dim == 'y' ? this->problem_.ny : this->problem_.nz);
+	}
+
+	index_t next_axis(index_t axis) const
+	{
+		if (this->problem_.dims == 1)
+			return 0;
+		if (this->problem_.dims == 2)
+			return 1 - axis;
+		return (axis + 1) % 3;
+	}
+
+	std::size_t get_size() const
+	{
+		return (std::size_t)this->problem_.substrates_count * this->problem_.nx * this->problem_.ny * this->problem_.nz;
+	}
+
+	// The layout with the outermost dimension r_dim, then a_dim, b_dim and s
+	// The substrates count is either index_t or noarr::lit for the specialized kernels
+	template <char r_dim, char a_dim, char b_dim, typename substrates_count_t>
+	auto get_rotated_layout(substrates_count_t substrates_count) const
+	{
+		return noarr::scalar<real_t>()
+			   ^ noarr::vectors<'s', b_dim, a_dim, r_dim>(substrates_count, get_length(b_dim), get_length(a_dim),
+														  get_length(r_dim));
+	}
+
+	// Solves the r_dim lines of the layout (r_dim, a_dim, b_dim) and writes them to rotated_ in the layout
+	// (b_dim, r_dim, a_dim); with null b, the densities are only transposed
+	template <char r_dim, char a_dim, char b_dim>
+	void rotate_omp(const real_t* b, const real_t* c, const real_t* e);
+
+	// Rotates the densities by plain transposes until the layout serves the sweep of the axis
+	void rotate_to_omp(index_t axis);
+
+	void solve_x_omp() override;
+	void solve_y_omp() override;
+	void solve_z_omp() override;
+
+public:
+	void tune(const nlohmann::json& params) override;
+
+	// the rotated layouts are not padded
+	std::size_t allocated_elements(const max_problem_t& problem) const override
+	{
+		return diffusion_solver::allocated_elements(problem);
+	}
+
+	void prepare(const max_problem_t& problem) override;
+
+	void initialize() override;
+
+	std::span<const std::byte> substrates_memory() const override;
+
+	double access(std::size_t s, std::size_t x, std::size_t y, std::size_t z) const override;
+};
@@ -1,16 +1,46 @@
 #pragma once
 
+#include <algorithm>
 #include <math.h>
+#include <utility>
 
 #include <noarr/traversers.hpp>
 
+#include "aligned_allocator.h"
+#include "isa_dispatch.h"
 #include "noarr/structures/extra/funcs.hpp"
 #include "omp_helper.h"
 #include "problem.h"
 
 class solver_utils
 {
+	template <typename index_t, typename func_t, std::size_t... counts>
+	static bool dispatch_literal_substrates_count(index_t substrates_count, func_t& func,
+												  std::index_sequence<counts...>)
+	{
+		return ((substrates_count == (index_t)counts && (func(noarr::lit<counts>), true)) || ...);
+	}
+
 public:
+	// The substrate counts the sweeps have specialized kernels for
+	using specialized_substrates_counts = std::index_sequence<1, 2, 4, 8, 16>;
+
+	// Calls func with the substrates count as noarr::lit if it is one of the specialized counts, otherwise with the
+	// runtime value. The layouts built from the literal have the substrate length known at compile time, so the kernels
+	// instantiated for them have constant trip counts of the substrate loops and the compiler can fully unroll them.
+	// The call runs in the clone of the selected instruction set (see isa_dispatch), so it has to be made inside the
+	// parallel region.
+	template <typename index_t, typename func_t>
+	static void dispatch_substrates_count(index_t substrates_count, bool specialized, func_t&& func)
+	{
+		isa_dispatch::run([&] {
+			if (specialized
+				&& dispatch_literal_substrates_count(substrates_count, func, specialized_substrates_counts {}))
+				return;
+
+			func(substrates_count);
+		});
+	}
 	template <typename index_t, typename real_t>
 	static real_t gaussian_analytical_solution(index_t s, index_t x, index_t y, index_t z, real_t time,
 											   const problem_t<index_t, real_t>& problem)
@@ -46,8 +76,85 @@ public:
 			   / std::pow(4 * M_PI * problem.diffusion_coefficients[s] * time, problem.dims / 2);
 	}
 
-	template <typename index_t, typename real_t>
-	static void initialize_substrate(auto substrates_layout, real_t* substrates,
+	// Zero-initializes the substrates in parallel with the dimension 'dim' distributed among the threads in the same
+	// way as by omp for schedule(static, work_items), so each page is first touched (and placed to the NUMA node) by
+	// the thread which processes it in the sweeps
+	template <char dim, typename real_t>
+	static void first_touch(auto substrates_layout, real_t* substrates, std::size_t work_items)
+	{
+		const std::size_t n = substrates_layout | noarr::get_length<dim>();
+
+#pragma omp parallel for schedule(static, work_items)
+		for (std::size_t i = 0; i < n; i++)
+		{
+			auto slice_layout = substrates_layout ^ noarr::fix<dim>(i);
+
+			noarr::traverser(slice_layout).for_each(
+				[&](auto state) { (slice_layout | noarr::get_at(substrates, state)) = 0; });
+		}
+	}
+
+	// Solves the lines along the dimension 'i' by a batched LAPACK solve. The lines are strided, so batches of
+	// batch_size neighbouring lines (dimension 'q') are gathered to a scratch buffer as columns of the right hand side
+	// matrix, solved by solve_batch(s, scratch, n, rhs) which returns the LAPACK info, and scattered back.
+	// Returns the first nonzero info or 0; the caller throws, as an exception can not leave the parallel region.
+	template <typename real_t, typename func_t>
+	static int solve_strided_lines(auto dens_l, real_t* densities, const aligned_allocator& allocator, int batch_size,
+								   func_t&& solve_batch)
+	{
+		const int n = dens_l | noarr::get_length<'i'>();
+		const int q_len = dens_l | noarr::get_length<'q'>();
+		const int m_len = dens_l | noarr::get_length<'m'>();
+		const int substrates_count = dens_l | noarr::get_length<'s'>();
+
+		const int batches = (q_len + batch_size - 1) / batch_size;
+
+		auto scratch_l = noarr::scalar<real_t>() ^ noarr::vectors<'i', 'q'>(n, batch_size);
+
+		int failed_info = 0;
+
+#pragma omp parallel
+		{
+			auto scratch = allocator.allocate<real_t>(n * batch_size);
+
+#pragma omp for schedule(static) collapse(3)
+			for (int s = 0; s < substrates_count; s++)
+			{
+				for (int m = 0; m < m_len; m++)
+				{
+					for (int batch = 0; batch < batches; batch++)
+					{
+						const int q_begin = batch * batch_size;
+						const int rhs = std::min(batch_size, q_len - q_begin);
+
+						for (int i = 0; i < n; i++)
+							for (int q = 0; q < rhs; q++)
+								(scratch_l | noarr::get_at<'i', 'q'>(scratch.get(), i, q)) =
+									(dens_l | noarr::get_at<'i', 'q', 'm', 's'>(densities, i, q_begin + q, m, s));
+
+						const int info = solve_batch(s, scratch.get(), n, rhs);
+
+						if (info != 0)
+						{
+#pragma omp critical
+							if (failed_info == 0)
+								failed_info = info;
+						}
+
+						for (int i = 0; i < n; i++)
+							for (int q = 0; q < rhs; q++)
+								(dens_l | noarr::get_at<'i', 'q', 'm', 's'>(densities, i, q_begin + q, m, s)) =
+									(scratch_l | noarr::get_at<'i', 'q'>(scratch.get(), i, q));
+					}
+				}
+			}
+		}
+
+		return failed_info;
+	}
+
+	template <typename index_t, typename real_t, typename density_t>
+	static void initialize_substrate(auto substrates_layout, density_t* substrates,
 									 const problem_t<index_t, real_t>& problem)
 	{
 		if (problem.gaussian_pulse)
@@ -60,8 +167,8 @@ public:
 		}
 	}
 
-	template <typename real_t>
-	static void initialize_substrate_constant(auto substrates_layout, real_t* substrates,
+	template <typename real_t, typename density_t>
+	static void initialize_substrate_constant(auto substrates_layout, density_t* substrates,
 											  const real_t* initial_conditions)
 	{
 		omp_trav_for_each(noarr::traverser(substrates_layout), [&](auto state) {
@@ -81,8 +188,8 @@ public:
 		});
 	}
 
-	template <typename index_t, typename real_t>
-	static void initialize_gaussian_pulse(auto substrates_layout, real_t* substrates,
+	template <typename index_t, typename real_t, typename density_t>
+	static void initialize_gaussian_pulse(auto substrates_layout, density_t* substrates,
 										  const problem_t<index_t, real_t>& problem)
 	{
 		constexpr real_t initial_pulse_time = 0.01;
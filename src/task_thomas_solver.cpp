@@ -0,0 +1,178 @@
+#include "task_thomas_solver.h"
+
+#include <algorithm>
+#include <omp.h>
+
+#include "least_compute_thomas_kernels.h"
+
+template <typename real_t, typename index_t>
+void task_thomas_solver<real_t, index_t>::tune(const nlohmann::json& params)
+{
+	base_t::tune(params);
+
+	pencils_ = params.contains("pencils") ? (std::size_t)params["pencils"] : 2 * omp_get_max_threads();
+	z_chunk_size_ = params.contains("z_chunk_size") ? (std::size_t)params["z_chunk_size"] : 8;
+}
+
+template <typename real_t, typename index_t>
+void task_thomas_solver<real_t, index_t>::initialize()
+{
+	base_t::initialize();
+
+	pencils_ = std::clamp<std::size_t>(pencils_, 1, this->problem_.nx * this->problem_.ny);
+	z_chunk_size_ = std::max<std::size_t>(z_chunk_size_, 1);
+
+	plane_deps_ = std::make_unique<char[]>(this->problem_.nz);
+	pencil_deps_ = std::make_unique<char[]>(pencils_);
+}
+
+// Forward substitution of the planes [begin, end) of the pencil of (y, x) points [yx_begin, yx_end)
+template <typename index_t, typename real_t, typename density_layout_t>
+void solve_pencil_z_forward(real_t* __restrict__ densities, const real_t* __restrict__ e,
+							const density_layout_t dens_l, index_t yx_begin, index_t yx_end, index_t begin,
+							index_t end)
+{
+	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+	const index_t n = dens_l | noarr::get_length<'z'>();
+
+	auto diag_l = noarr::scalar<real_t>() ^ noarr::vector<'s'>(substrates_count) ^ noarr::vector<'i'>(n);
+
+	for (index_t i = std::max<index_t>(begin, 1); i < end; i++)
+	{
+		for (index_t yx = yx_begin; yx < yx_end; yx++)
+		{
+#pragma omp simd
+			for (index_t s = 0; s < substrates_count; s++)
+			{
+				(dens_l | noarr::get_at<'z', 'm', 's'>(densities, i, yx, s)) =
+					(dens_l | noarr::get_at<'z', 'm', 's'>(densities, i, yx, s))
+					- (diag_l | noarr::get_at<'i', 's'>(e, i - 1, s))
+						  * (dens_l | noarr::get_at<'z', 'm', 's'>(densities, i - 1, yx, s));
+			}
+		}
+	}
+}
+
+// Backward substitution of the planes [begin, end) of the pencil of (y, x) points [yx_begin, yx_end)
+template <typename index_t, typename real_t, typename density_layout_t>
+void solve_pencil_z_backward(real_t* __restrict__ densities, const real_t* __restrict__ b,
+							 const real_t* __restrict__ c, const density_layout_t dens_l, index_t yx_begin,
+							 index_t yx_end, index_t begin, index_t end)
+{
+	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+	const index_t n = dens_l | noarr::get_length<'z'>();
+
+	auto diag_l = noarr::scalar<real_t>() ^ noarr::vector<'s'>(substrates_count) ^ noarr::vector<'i'>(n);
+
+	if (end == n)
+	{
+		for (index_t yx = yx_begin; yx < yx_end; yx++)
+		{
+#pragma omp simd
+			for (index_t s = 0; s < substrates_count; s++)
+			{
+				(dens_l | noarr::get_at<'z', 'm', 's'>(densities, n - 1, yx, s)) =
+					(dens_l | noarr::get_at<'z', 'm', 's'>(densities, n - 1, yx, s))
+					* (diag_l | noarr::get_at<'i', 's'>(b, n - 1, s));
+			}
+		}
+
+		end--;
+	}
+
+	for (index_t i = end - 1; i >= begin; i--)
+	{
+		for (index_t yx = yx_begin; yx < yx_end; yx++)
+		{
+#pragma omp simd
+			for (index_t s = 0; s < substrates_count; s++)
+			{
+				(dens_l | noarr::get_at<'z', 'm', 's'>(densities, i, yx, s)) =
+					((dens_l | noarr::get_at<'z', 'm', 's'>(densities, i, yx, s))
+					 - c[s] * (dens_l | noarr::get_at<'z', 'm', 's'>(densities, i + 1, yx, s)))
+					* (diag_l | noarr::get_at<'i', 's'>(b, i, s));
+			}
+		}
+	}
+}
+
+template <typename real_t, typename index_t>
+void task_thomas_solver<real_t, index_t>::solve()
+{
+	if (this->problem_.dims != 3)
+		base_t::solve();
+	else
+		solve_iterations(1);
+}
+
+template <typename real_t, typename index_t>
+void task_thomas_solver<real_t, index_t>::solve_iterations(std::size_t iterations)
+{
+	if (this->problem_.dims != 3)
+	{
+		base_t::solve_iterations(iterations);
+		return;
+	}
+
+	const index_t nz = this->problem_.nz;
+	const index_t ny = this->problem_.ny;
+	const index_t plane_size = this->problem_.nx * this->problem_.ny;
+	const index_t pencils = pencils_;
+	const index_t z_chunk_size = z_chunk_size_;
+
+	real_t* densities = this->substrates_.get();
+	char* plane_deps = plane_deps_.get();
+	char* pencil_deps = pencil_deps_.get();
+
+	auto dens_l = base_t::template get_substrates_layout<3>(this->problem_);
+	auto x_dens_l = dens_l ^ noarr::merge_blocks<'z', 'y', 'm'>();
+	auto z_dens_l = dens_l ^ noarr::merge_blocks<'y', 'x', 'm'>();
+
+#pragma omp parallel
+#pragma omp single
+	for (std::size_t iteration = 0; iteration < iterations; iteration++)
+	{
+		for (index_t z = 0; z < nz; z++)
+		{
+#pragma omp task depend(inout : plane_deps[z])
+			{
+				for (index_t y = 0; y < ny; y++)
+					solve_line_x<index_t>(densities, this->bx_.get(), this->cx_.get(), this->ex_.get(), x_dens_l,
+										  z * ny + y);
+
+				solve_slab_y<index_t>(densities, this->by_.get(), this->cy_.get(), this->ey_.get(), dens_l, z);
+			}
+		}
+
+		for (index_t p = 0; p < pencils; p++)
+		{
+			const index_t yx_begin = p * plane_size / pencils;
+			const index_t yx_end = (p + 1) * plane_size / pencils;
+
+			for (index_t begin = 0; begin < nz; begin += z_chunk_size)
+			{
+				const index_t end = std::min(begin + z_chunk_size, nz);
+
+#pragma omp task depend(inout : pencil_deps[p]) depend(iterator(it = begin : end), in : plane_deps[it])
+				solve_pencil_z_forward<index_t>(densities, this->ez_.get(), z_dens_l, yx_begin, yx_end, begin, end);
+			}
+
+			for (index_t end = nz; end > 0; end -= std::min(end, z_chunk_size))
+			{
+				const index_t begin = std::max<index_t>(end - z_chunk_size, 0);
+
+				// the plane 'end' is read by the chunk as well
+				const index_t last_read = std::min(end + 1, nz);
+
+#pragma omp task depend(inout : pencil_deps[p]) depend(iterator(it = begin : last_read), in : plane_deps[it])
+				solve_pencil_z_backward<index_t>(densities, this->bz_.get(), this->cz_.get(), z_dens_l, yx_begin,
+												 yx_end, begin, end);
+			}
+		}
+	}
+}
+
+template class task_thomas_solver<float, std::int32_t>;
+template class task_thomas_solver<float, std::int64_t>;
+template class task_thomas_solver<double, std::int32_t>;
+template class task_thomas_solver<double, std::int64_t>;
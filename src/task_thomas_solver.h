@@ -0,0 +1,40 @@
+#pragma once
+
+#include "least_compute_thomas_solver.h"
+
+/*
+The same solver as least_compute_thomas_solver, but the time steps are scheduled as a graph of OpenMP tasks instead of
+sweeps separated by global barriers (3D only, 1D and 2D problems fall back to the barrier version).
+
+The tasks of a step are:
+- slab task for each z plane, solving the x and y sweeps of the plane,
+- forward and backward z tasks for each pencil (a part of the (y, x) plane) and each chunk of z planes.
+
+The dependencies are expressed on per-plane and per-pencil tokens:
+- the chunk tasks of a pencil are chained by the pencil token,
+- the forward chunk task needs the slab tasks of its planes,
+- the slab task of the next step needs all the chunk tasks reading or writing its plane.
+So a slab task can start as soon as the z sweep of all pencils has moved past its plane, and the z sweep of a pencil
+can start as soon as the slabs of its first chunk are done.
+*/
+
+template <typename real_t, typename index_t>
+class task_thomas_solver : public least_compute_thomas_solver<real_t, index_t>
+{
+	using base_t = least_compute_thomas_solver<real_t, index_t>;
+
+	std::size_t pencils_;
+	std::size_t z_chunk_size_;
+
+	// dependency tokens of the tasks
+	std::unique_ptr<char[]> plane_deps_, pencil_deps_;
+
+public:
+	void tune(const nlohmann::json& params) override;
+
+	void initialize() override;
+
+	void solve() override;
+
+	void solve_iterations(std::size_t iterations) override;
+};
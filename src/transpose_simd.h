@@ -0,0 +1,203 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+	#include <immintrin.h>
+#endif
+
+/*
+Minimal SIMD abstraction for kernels that keep several lines in registers, transpose them and run the recurrences of
+the lines in SIMD lanes. A square block of width x width elements is transposed in log2(width) stages; in the stage k,
+rows i and i+k (for each i with (i & k) == 0) exchange their off-diagonal k-element sub-blocks.
+
+transpose_simd<real_t>::available is false when no supported instruction set is enabled at the compile time.
+*/
+
+template <typename real_t>
+struct transpose_simd
+{
+	static constexpr bool available = false;
+};
+
+#if defined(__AVX512F__)
+
+// Indices for permutex2var, where the index bit 'width' selects the second source
+template <typename int_t, std::size_t width, std::size_t k, bool upper>
+constexpr std::array<int_t, width> transpose_stage_indices()
+{
+	std::array<int_t, width> indices {};
+
+	for (std::size_t p = 0; p < width; p++)
+	{
+		if (!upper)
+			indices[p] = (p & k) ? (int_t)((p - k) | width) : (int_t)p;
+		else
+			indices[p] = (p & k) ? (int_t)(p | width) : (int_t)(p + k);
+	}
+
+	return indices;
+}
+
+template <>
+struct transpose_simd<float>
+{
+	static constexpr bool available = true;
+	static constexpr std::size_t width = 16;
+
+	using vec_t = __m512;
+
+	static vec_t load(const float* ptr) { return _mm512_loadu_ps(ptr); }
+	static void store(float* ptr, vec_t v) { _mm512_storeu_ps(ptr, v); }
+	static vec_t set1(float x) { return _mm512_set1_ps(x); }
+	static vec_t zero() { return _mm512_setzero_ps(); }
+
+	// c - a*b
+	static vec_t fnmadd(vec_t a, vec_t b, vec_t c) { return _mm512_fnmadd_ps(a, b, c); }
+	static vec_t mul(vec_t a, vec_t b) { return _mm512_mul_ps(a, b); }
+
+	template <std::size_t k>
+	static void transpose_stage(vec_t& lower, vec_t& upper)
+	{
+		static constexpr auto lower_indices = transpose_stage_indices<std::int32_t, width, k, false>();
+		static constexpr auto upper_indices = transpose_stage_indices<std::int32_t, width, k, true>();
+
+		vec_t l = _mm512_permutex2var_ps(lower, _mm512_loadu_si512(lower_indices.data()), upper);
+		vec_t u = _mm512_permutex2var_ps(lower, _mm512_loadu_si512(upper_indices.data()), upper);
+
+		lower = l;
+		upper = u;
+	}
+};
+
+template <>
+struct transpose_simd<double>
+{
+	static constexpr bool available = true;
+	static constexpr std::size_t width = 8;
+
+	using vec_t = __m512d;
+
+	static vec_t load(const double* ptr) { return _mm512_loadu_pd(ptr); }
+	static void store(double* ptr, vec_t v) { _mm512_storeu_pd(ptr, v); }
+	static vec_t set1(double x) { return _mm512_set1_pd(x); }
+	static vec_t zero() { return _mm512_setzero_pd(); }
+
+	// c - a*b
+	static vec_t fnmadd(vec_t a, vec_t b, vec_t c) { return _mm512_fnmadd_pd(a, b, c); }
+	static vec_t mul(vec_t a, vec_t b) { return _mm512_mul_pd(a, b); }
+
+	template <std::size_t k>
+	static void transpose_stage(vec_t& lower, vec_t& upper)
+	{
+		static constexpr auto lower_indices = transpose_stage_indices<std::int64_t, width, k, false>();
+		static constexpr auto upper_indices = transpose_stage_indices<std::int64_t, width, k, true>();
+
+		vec_t l = _mm512_permutex2var_pd(lower, _mm512_loadu_si512(lower_indices.data()), upper);
+		vec_t u = _mm512_permutex2var_pd(lower, _mm512_loadu_si512(upper_indices.data()), upper);
+
+		lower = l;
+		upper = u;
+	}
+};
+
+#elif defined(__AVX2__)
+
+template <>
+struct transpose_simd<float>
+{
+	static constexpr bool available = true;
+	static constexpr std::size_t width = 8;
+
+	using vec_t = __m256;
+
+	static vec_t load(const float* ptr) { return _mm256_loadu_ps(ptr); }
+	static void store(float* ptr, vec_t v) { _mm256_storeu_ps(ptr, v); }
+	static vec_t set1(float x) { return _mm256_set1_ps(x); }
+	static vec_t zero() { return _mm256_setzero_ps(); }
+
+	// c - a*b
+	static vec_t fnmadd(vec_t a, vec_t b, vec_t c) { return _mm256_fnmadd_ps(a, b, c); }
+	static vec_t mul(vec_t a, vec_t b) { return _mm256_mul_ps(a, b); }
+
+	template <std::size_t k>
+	static void transpose_stage(vec_t& lower, vec_t& upper)
+	{
+		vec_t l, u;
+
+		if constexpr (k == 1)
+		{
+			l = _mm256_blend_ps(lower, _mm256_moveldup_ps(upper), 0xAA);
+			u = _mm256_blend_ps(_mm256_movehdup_ps(lower), upper, 0xAA);
+		}
+		else if constexpr (k == 2)
+		{
+			l = _mm256_blend_ps(lower, _mm256_permute_ps(upper, _MM_SHUFFLE(1, 0, 1, 0)), 0xCC);
+			u = _mm256_blend_ps(_mm256_permute_ps(lower, _MM_SHUFFLE(3, 2, 3, 2)), upper, 0xCC);
+		}
+		else
+		{
+			l = _mm256_permute2f128_ps(lower, upper, 0x20);
+			u = _mm256_permute2f128_ps(lower, upper, 0x31);
+		}
+
+		lower = l;
+		upper = u;
+	}
+};
+
+template <>
+struct transpose_simd<double>
+{
+	static constexpr bool available = true;
+	static constexpr std::size_t width = 4;
+
+	using vec_t = __m256d;
+
+	static vec_t load(const double* ptr) { return _mm256_loadu_pd(ptr); }
+	static void store(double* ptr, vec_t v) { _mm256_storeu_pd(ptr, v); }
+	static vec_t set1(double x) { return _mm256_set1_pd(x); }
+	static vec_t zero() { return _mm256_setzero_pd(); }
+
+	// c - a*b
+	static vec_t fnmadd(vec_t a, vec_t b, vec_t c) { return _mm256_fnmadd_pd(a, b, c); }
+	static vec_t mul(vec_t a, vec_t b) { return _mm256_mul_pd(a, b); }
+
+	template <std::size_t k>
+	static void transpose_stage(vec_t& lower, vec_t& upper)
+	{
+		vec_t l, u;
+
+		if constexpr (k == 1)
+		{
+			l = _mm256_unpacklo_pd(lower, upper);
+			u = _mm256_unpackhi_pd(lower, upper);
+		}
+		else
+		{
+			l = _mm256_permute2f128_pd(lower, upper, 0x20);
+			u = _mm256_permute2f128_pd(lower, upper, 0x31);
+		}
+
+		lower = l;
+		upper = u;
+	}
+};
+
+#endif
+
+// Transposes width x width block stored in rows
+template <typename simd_t, std::size_t k = 1>
+inline void transpose_block(typename simd_t::vec_t* rows)
+{
+	if constexpr (k < simd_t::width)
+	{
+		for (std::size_t i = 0; i < simd_t::width; i++)
+			if ((i & k) == 0)
+				simd_t::template transpose_stage<k>(rows[i], rows[i + k]);
+
+		transpose_block<simd_t, 2 * k>(rows);
+	}
+}